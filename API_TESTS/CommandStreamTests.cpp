@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <d3d12.h>
+#include <array>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+import TypedD3D12;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	//Records the calls replayed onto it so streams can be checked without a device
+	struct FakeCommandList
+	{
+		std::vector<std::string> calls;
+		std::vector<UINT> values;
+
+		FakeCommandList* operator->() { return this; }
+
+		void SetPipelineState(WrapperView<ID3D12PipelineState>) { calls.push_back("SetPipelineState"); }
+		void SetGraphicsRootSignature(WrapperView<ID3D12RootSignature>) { calls.push_back("SetGraphicsRootSignature"); }
+		void SetComputeRootSignature(WrapperView<ID3D12RootSignature>) { calls.push_back("SetComputeRootSignature"); }
+		void SetDescriptorHeaps(ShaderVisible<CBV_SRV_UAV<ID3D12DescriptorHeap>>) { calls.push_back("SetDescriptorHeaps"); }
+		void SetDescriptorHeaps(ShaderVisible<Sampler<ID3D12DescriptorHeap>>) { calls.push_back("SetDescriptorHeaps"); }
+		void SetDescriptorHeaps(ShaderVisible<CBV_SRV_UAV<ID3D12DescriptorHeap>>, ShaderVisible<Sampler<ID3D12DescriptorHeap>>) { calls.push_back("SetDescriptorHeaps"); }
+		void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology) { calls.push_back("IASetPrimitiveTopology"); values.push_back(topology); }
+		void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) { calls.push_back("IASetIndexBuffer"); values.push_back(view ? view->SizeInBytes : 0); }
+		void IASetVertexBuffers(UINT startSlot, std::span<const D3D12_VERTEX_BUFFER_VIEW> views) { calls.push_back("IASetVertexBuffers"); values.push_back(startSlot); values.push_back(static_cast<UINT>(views.size())); }
+		void RSSetViewports(std::span<D3D12_VIEWPORT> viewports) { calls.push_back("RSSetViewports"); values.push_back(static_cast<UINT>(viewports[0].Width)); }
+		void RSSetScissorRects(std::span<D3D12_RECT> rects) { calls.push_back("RSSetScissorRects"); values.push_back(rects[0].right); }
+		void OMSetRenderTargets(Span<const RTV<D3D12_CPU_DESCRIPTOR_HANDLE>> renderTargets, BOOL, const DSV<D3D12_CPU_DESCRIPTOR_HANDLE>* depthStencil) { calls.push_back("OMSetRenderTargets"); values.push_back(static_cast<UINT>(renderTargets.size())); values.push_back(depthStencil ? static_cast<UINT>(depthStencil->Raw().ptr) : 0); }
+		void OMSetStencilRef(UINT stencilRef) { calls.push_back("OMSetStencilRef"); values.push_back(stencilRef); }
+		void OMSetBlendFactor(std::span<const float, 4> factor) { calls.push_back("OMSetBlendFactor"); values.push_back(static_cast<UINT>(factor[3])); }
+		void ClearRenderTargetView(RTV<D3D12_CPU_DESCRIPTOR_HANDLE>, std::span<const float, 4> color, std::span<const D3D12_RECT> rects) { calls.push_back("ClearRenderTargetView"); values.push_back(static_cast<UINT>(color[0])); values.push_back(static_cast<UINT>(rects.size())); }
+		void ClearDepthStencilView(DSV<D3D12_CPU_DESCRIPTOR_HANDLE>, D3D12_CLEAR_FLAGS, FLOAT, UINT8 stencil, std::span<const D3D12_RECT>) { calls.push_back("ClearDepthStencilView"); values.push_back(stencil); }
+		void SetGraphicsRoot32BitConstants(UINT index, UINT count, const void* data, UINT) { calls.push_back("SetGraphicsRoot32BitConstants"); values.push_back(index); values.insert(values.end(), static_cast<const UINT*>(data), static_cast<const UINT*>(data) + count); }
+		void SetComputeRoot32BitConstants(UINT index, UINT, const void*, UINT) { calls.push_back("SetComputeRoot32BitConstants"); values.push_back(index); }
+		void SetGraphicsRootConstantBufferView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS) { calls.push_back("SetGraphicsRootConstantBufferView"); values.push_back(index); }
+		void SetComputeRootConstantBufferView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS) { calls.push_back("SetComputeRootConstantBufferView"); values.push_back(index); }
+		void SetGraphicsRootShaderResourceView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS) { calls.push_back("SetGraphicsRootShaderResourceView"); values.push_back(index); }
+		void SetComputeRootShaderResourceView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS) { calls.push_back("SetComputeRootShaderResourceView"); values.push_back(index); }
+		void SetGraphicsRootUnorderedAccessView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS) { calls.push_back("SetGraphicsRootUnorderedAccessView"); values.push_back(index); }
+		void SetComputeRootUnorderedAccessView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS) { calls.push_back("SetComputeRootUnorderedAccessView"); values.push_back(index); }
+		void SetGraphicsRootDescriptorTable(UINT index, D3D12_GPU_DESCRIPTOR_HANDLE) { calls.push_back("SetGraphicsRootDescriptorTable"); values.push_back(index); }
+		void SetComputeRootDescriptorTable(UINT index, D3D12_GPU_DESCRIPTOR_HANDLE) { calls.push_back("SetComputeRootDescriptorTable"); values.push_back(index); }
+		void DrawInstanced(UINT vertexCount, UINT, UINT, UINT) { calls.push_back("DrawInstanced"); values.push_back(vertexCount); }
+		void DrawIndexedInstanced(UINT indexCount, UINT, UINT, INT baseVertex, UINT) { calls.push_back("DrawIndexedInstanced"); values.push_back(indexCount); values.push_back(static_cast<UINT>(baseVertex)); }
+		void Dispatch(UINT x, UINT y, UINT z) { calls.push_back("Dispatch"); values.push_back(x * y * z); }
+		void ExecuteIndirect(gsl::not_null<WrapperView<ID3D12CommandSignature>>, UINT maxCount, gsl::not_null<WrapperView<ID3D12Resource>>, UINT64, WrapperView<ID3D12Resource>, UINT64) { calls.push_back("ExecuteIndirect"); values.push_back(maxCount); }
+		void ResourceBarrier(std::span<const D3D12_RESOURCE_BARRIER> barriers) { calls.push_back("ResourceBarrier"); values.push_back(static_cast<UINT>(barriers.size())); }
+		void CopyBufferRegion(gsl::not_null<WrapperView<ID3D12Resource>>, UINT64, gsl::not_null<WrapperView<ID3D12Resource>>, UINT64, UINT64 numBytes) { calls.push_back("CopyBufferRegion"); values.push_back(static_cast<UINT>(numBytes)); }
+		void CopyResource(gsl::not_null<WrapperView<ID3D12Resource>>, gsl::not_null<WrapperView<ID3D12Resource>>) { calls.push_back("CopyResource"); }
+	};
+
+	TEST_CLASS(CommandStreamTests)
+	{
+	public:
+		TEST_METHOD(ReplaysCommandsWithArguments)
+		{
+			D3D12::CommandStream stream;
+			D3D12_VIEWPORT viewport{ .Width = 1280, .Height = 720 };
+			D3D12_RECT scissor{ .right = 1280, .bottom = 720 };
+			UINT constants[] = { 7, 8, 9 };
+			D3D12_INDEX_BUFFER_VIEW indexBuffer{ .SizeInBytes = 96 };
+			RTV<D3D12_CPU_DESCRIPTOR_HANDLE> renderTargets[] = { D3D12_CPU_DESCRIPTOR_HANDLE{ 16 }, D3D12_CPU_DESCRIPTOR_HANDLE{ 32 } };
+			DSV<D3D12_CPU_DESCRIPTOR_HANDLE> depthStencil = D3D12_CPU_DESCRIPTOR_HANDLE{ 48 };
+
+			stream.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			stream.IASetIndexBuffer(&indexBuffer);
+			stream.RSSetViewports(std::span(&viewport, 1));
+			stream.RSSetScissorRects(std::span(&scissor, 1));
+			stream.OMSetRenderTargets(Span<const RTV<D3D12_CPU_DESCRIPTOR_HANDLE>>(&renderTargets[0].Raw(), 2), false, &depthStencil);
+			stream.ClearRenderTargetView(renderTargets[0], { 3.f, 0.f, 0.f, 1.f });
+			stream.SetGraphicsRoot32BitConstants(2, 3, constants, 0);
+			stream.DrawIndexedInstanced(36, 1, 0, -4, 0);
+			stream.Dispatch(2, 3, 4);
+
+			FakeCommandList list;
+			stream.Replay(list);
+
+			std::vector<std::string> expectedCalls{ "IASetPrimitiveTopology", "IASetIndexBuffer", "RSSetViewports", "RSSetScissorRects", "OMSetRenderTargets", "ClearRenderTargetView", "SetGraphicsRoot32BitConstants", "DrawIndexedInstanced", "Dispatch" };
+			std::vector<UINT> expectedValues{ D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST, 96, 1280, 1280, 2, 48, 3, 0, 2, 7, 8, 9, 36, static_cast<UINT>(-4), 24 };
+			Assert::IsTrue(expectedCalls == list.calls);
+			Assert::IsTrue(expectedValues == list.values);
+			Assert::AreEqual<size_t>(9, stream.GetCommandCount());
+		}
+
+		TEST_METHOD(OversizedSpansAreRejected)
+		{
+			D3D12::CommandStream stream;
+			std::array<D3D12_VIEWPORT, D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE + 1> viewports{};
+			std::array<D3D12_RECT, D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE + 1> rects{};
+			std::array<RTV<D3D12_CPU_DESCRIPTOR_HANDLE>, D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 1> renderTargets{};
+
+			Assert::ExpectException<std::invalid_argument>([&] { stream.RSSetViewports(viewports); });
+			Assert::ExpectException<std::invalid_argument>([&] { stream.RSSetScissorRects(rects); });
+			Assert::ExpectException<std::invalid_argument>([&] { stream.OMSetRenderTargets(Span<const RTV<D3D12_CPU_DESCRIPTOR_HANDLE>>(&renderTargets[0].Raw(), renderTargets.size()), false, nullptr); });
+			Assert::AreEqual<size_t>(0, stream.GetCommandCount());
+
+			//The largest spans allowed still record and replay
+			stream.RSSetViewports(std::span(viewports).first<D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE>());
+			FakeCommandList list;
+			stream.Replay(list);
+			Assert::AreEqual<size_t>(1, list.calls.size());
+		}
+
+		TEST_METHOD(CommandsArePackedAndAligned)
+		{
+			D3D12::CommandStream stream;
+			stream.DrawInstanced(3, 1, 0, 0);
+			stream.OMSetStencilRef(1);
+			Assert::AreEqual<size_t>(0, stream.GetSizeInBytes() % 8);
+
+			//Header plus five UINTs padded to 8 bytes, then header plus one UINT padded
+			Assert::AreEqual<size_t>(8 + 24 + 8 + 8, stream.GetSizeInBytes());
+		}
+
+		TEST_METHOD(AppendedStreamsReplayInOrder)
+		{
+			D3D12::CommandStream first;
+			D3D12::CommandStream second;
+			second.DrawInstanced(6, 1, 0, 0);
+			first.OMSetStencilRef(5);
+			first.Append(second);
+			first.Append(second);
+
+			std::vector<D3D12::CommandId> expectedIds{ D3D12::CommandId::OMSetStencilRef, D3D12::CommandId::DrawInstanced, D3D12::CommandId::DrawInstanced };
+			Assert::IsTrue(expectedIds == first.GetCommandIds());
+
+			FakeCommandList list;
+			first.Replay(list);
+			Assert::IsTrue(std::vector<UINT>{ 5, 6, 6 } == list.values);
+		}
+	};
+}
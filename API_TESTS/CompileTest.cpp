@@ -361,4 +361,57 @@ static void ContainersTest()
 
 	//SpanInput3(cpuHandle2); //shouldn't compile
 	SpanInput4(cpuHandle2);
-}
\ No newline at end of file
+}
+
+static void RootSignatureLayoutTest()
+{
+	struct PerDraw
+	{
+		float transform[16];
+		UINT materialIndex;
+		UINT padding[3];
+	};
+
+	using Layout = D3D12::RootSignatureLayout<D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT,
+		D3D12::RootConstants<PerDraw, 0>,
+		D3D12::RootCBV<1>,
+		D3D12::RootDescriptorTable<D3D12_SHADER_VISIBILITY_PIXEL, D3D12::DescriptorRange<D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 4, 0>>,
+		D3D12::RootDescriptorTable<D3D12_SHADER_VISIBILITY_PIXEL, D3D12::DescriptorRange<D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, 1, 0>>>;
+
+	static_assert(Layout::parameterCount == 4);
+	static_assert(Layout::parameters[0].Constants.Num32BitValues == 20);
+	static_assert(Layout::parameters[2].DescriptorTable.pDescriptorRanges[0].NumDescriptors == 4);
+
+	using Binder = D3D12::GraphicsRootBinder<Layout, Direct<ID3D12GraphicsCommandList>>;
+	static_assert(requires(Binder binder, PerDraw constants) { binder.Set<0>(constants); });
+	static_assert(requires(Binder binder, UINT constant) { binder.SetConstants<0, 16>(constant); });
+	static_assert(!requires(Binder binder, PerDraw constants) { binder.SetConstants<0, 1>(constants); });
+	static_assert(requires(Binder binder, D3D12_GPU_VIRTUAL_ADDRESS address) { binder.Set<1>(address); });
+	static_assert(requires(Binder binder, CBV_SRV_UAV<D3D12_GPU_DESCRIPTOR_HANDLE> handle) { binder.Set<2>(handle); });
+	static_assert(!requires(Binder binder, Sampler<D3D12_GPU_DESCRIPTOR_HANDLE> handle) { binder.Set<2>(handle); });
+	static_assert(requires(Binder binder, Sampler<D3D12_GPU_DESCRIPTOR_HANDLE> handle) { binder.Set<3>(handle); });
+	static_assert(!requires(Binder binder, D3D12_GPU_VIRTUAL_ADDRESS address) { binder.Set<4>(address); });
+}
+
+static void InstrumentationTest()
+{
+	//Without TYPEDD3D_INSTRUMENTATION the wrappers must call through the same argumentless Self, so the generated code is unchanged
+	using Base = InterfaceBase<Untagged<ID3D12Device>>;
+	static_assert(std::same_as<decltype(&Base::Self), ID3D12Device& (Base::*)()> == !Instrumentation::enabled);
+
+	//Reporting arguments must be constant evaluable when disabled, which rules out any side effect left in the wrappers
+	static_assert(noexcept(Instrumentation::AddArgumentCount(1)));
+	static_assert(Instrumentation::enabled || [] { Instrumentation::AddArgumentCount(1); return true; }());
+}
+
+static void ConstantBuffers1Test()
+{
+	static_assert(requires(Wrapper<ID3D11DeviceContext1> context, Wrapper<ID3D11Buffer> buffer, D3D11::ConstantBufferRange range)
+	{
+		context->VSSetConstantBuffers1(0, buffer, range.firstConstant, range.numConstants);
+		context->PSSetConstantBuffers1(0, buffer, range.firstConstant, range.numConstants);
+		context->CSSetConstantBuffers1(0, buffer, range.firstConstant, range.numConstants);
+		context->Draw(3, 0);
+	});
+	static_assert(!requires(Wrapper<ID3D11DeviceContext> context, Wrapper<ID3D11Buffer> buffer) { context->VSSetConstantBuffers1(0, buffer, 0, 16); });
+}
@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <d3d12.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+import TypedD3D12;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	//Records the state setting calls made while recording a draw queue
+	struct DrawRecordingList
+	{
+		std::vector<std::string> calls;
+
+		DrawRecordingList* operator->() { return this; }
+
+		void SetGraphicsRootSignature(WrapperView<ID3D12RootSignature>) { calls.push_back("SetGraphicsRootSignature"); }
+		void SetPipelineState(WrapperView<ID3D12PipelineState>) { calls.push_back("SetPipelineState"); }
+		void SetGraphicsRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) { calls.push_back("SetGraphicsRootDescriptorTable"); }
+		void SetGraphicsRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) { calls.push_back("SetGraphicsRootConstantBufferView"); }
+		void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY) { calls.push_back("IASetPrimitiveTopology"); }
+		void IASetVertexBuffers(UINT, std::span<const D3D12_VERTEX_BUFFER_VIEW>) { calls.push_back("IASetVertexBuffers"); }
+		void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW*) { calls.push_back("IASetIndexBuffer"); }
+		void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) { calls.push_back("DrawIndexedInstanced"); }
+	};
+
+	TEST_CLASS(DrawQueueTests)
+	{
+	public:
+		TEST_METHOD(RadixSortIsStable)
+		{
+			for(size_t taskCount : { 1, 4 })
+			{
+				D3D12::DrawQueue queue{ nullptr, taskCount };
+				std::mt19937_64 random{ 5 };
+				std::vector<UINT64> keys(100'000);
+				for(UINT64& key : keys)
+				{
+					//Few distinct keys so that stability matters, with some digits equal in every key so their passes are skipped
+					key = random() & 0xFF00'0F00'00F0'000Full;
+					queue.Push(key, {});
+				}
+
+				std::vector<UINT32> expected(keys.size());
+				std::iota(expected.begin(), expected.end(), 0u);
+				std::stable_sort(expected.begin(), expected.end(), [&](UINT32 left, UINT32 right) { return keys[left] < keys[right]; });
+
+				queue.Sort();
+				Assert::IsTrue(std::ranges::equal(expected, queue.GetSortedOrder()));
+				Assert::IsTrue(std::ranges::is_sorted(queue.GetSortedKeys()));
+			}
+		}
+
+		TEST_METHOD(StateIsOnlySetWhenKeyBitsChange)
+		{
+			D3D12::DrawQueue queue;
+			auto push = [&](UINT32 rootSignature, UINT32 pipelineState, UINT32 material, float depth)
+			{
+				D3D12::QueuedDraw draw;
+				draw.rootSignature = reinterpret_cast<ID3D12RootSignature*>(UINT_PTR(rootSignature + 1) * 16);
+				draw.pipelineState = reinterpret_cast<ID3D12PipelineState*>(UINT_PTR(pipelineState + 1) * 16);
+				draw.material.ptr = material;
+				queue.Push(D3D12::DrawKeyFields{ rootSignature, pipelineState, material, D3D12::DrawKeyFields::QuantizeDepth(depth) }, draw);
+			};
+
+			push(1, 2, 0, 0.5f);
+			push(0, 0, 1, 0.2f);
+			push(0, 1, 0, 0.1f);
+			push(0, 0, 1, 0.1f);
+			push(0, 0, 0, 0.9f);
+			push(1, 2, 0, 0.4f);
+
+			DrawRecordingList list;
+			D3D12::DrawQueueStatistics statistics = queue.Record(list, { .materialRootParameter = 0 });
+
+			Assert::AreEqual(6u, statistics.draws);
+			Assert::AreEqual(2u, statistics.rootSignatureChanges);
+			Assert::AreEqual(3u, statistics.pipelineStateChanges);
+			Assert::AreEqual(4u, statistics.materialChanges);
+			Assert::AreEqual(1u, statistics.geometryChanges);
+			Assert::AreEqual<size_t>(6, std::ranges::count(list.calls, "DrawIndexedInstanced"));
+			Assert::AreEqual<size_t>(2, std::ranges::count(list.calls, "SetGraphicsRootSignature"));
+		}
+	};
+}
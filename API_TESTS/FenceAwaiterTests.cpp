@@ -0,0 +1,215 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+import TypedD3D12;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	struct FakeFence
+	{
+		std::atomic<UINT64> value = 0;
+	};
+
+	class FakeFenceWaitBackend
+	{
+		std::mutex mutex;
+		std::condition_variable changed;
+		bool woken = false;
+
+	public:
+		using fence_type = FakeFence*;
+
+		std::atomic<bool> failWaits = false;
+
+		UINT64 GetCompletedValue(FakeFence* fence) { return fence->value.load(); }
+
+		void WaitAny(std::span<FakeFence* const> fences, std::span<UINT64> values)
+		{
+			if(failWaits)
+				throw std::runtime_error("Wait failed");
+
+			std::unique_lock lock{ mutex };
+			changed.wait(lock, [&]
+			{
+				if(woken)
+					return true;
+
+				for(size_t i = 0; i < fences.size(); i++)
+				{
+					if(fences[i]->value >= values[i])
+						return true;
+				}
+				return false;
+			});
+			woken = false;
+		}
+
+		void Wake()
+		{
+			{
+				std::scoped_lock lock{ mutex };
+				woken = true;
+			}
+			changed.notify_all();
+		}
+
+		void Signal(FakeFence& fence, UINT64 value)
+		{
+			{
+				std::scoped_lock lock{ mutex };
+				fence.value = value;
+			}
+			changed.notify_all();
+		}
+	};
+
+	struct FireAndForget
+	{
+		struct promise_type
+		{
+			FireAndForget get_return_object() { return {}; }
+			std::suspend_never initial_suspend() { return {}; }
+			std::suspend_never final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+	};
+
+	using FakeAwaiterService = D3D12::BasicFenceAwaiterService<FakeFenceWaitBackend>;
+
+	FireAndForget AwaitFence(FakeAwaiterService& service, FakeFence& fence, UINT64 value, std::atomic<int>& resumed)
+	{
+		co_await service.Wait(&fence, value);
+		resumed++;
+	}
+
+	//Written by the waiter thread before count is incremented, so it can be read once count is
+	struct ResumeLog
+	{
+		std::vector<int> order;
+		std::atomic<int> count = 0;
+	};
+
+	FireAndForget AwaitFenceLogged(FakeAwaiterService& service, FakeFence& fence, UINT64 value, int id, ResumeLog& log)
+	{
+		co_await service.Wait(&fence, value);
+		log.order.push_back(id);
+		log.count++;
+	}
+
+	FireAndForget AwaitFenceCatching(FakeAwaiterService& service, FakeFence& fence, UINT64 value, std::atomic<int>& failed)
+	{
+		try
+		{
+			co_await service.Wait(&fence, value);
+		}
+		catch(const std::runtime_error&)
+		{
+			failed++;
+		}
+	}
+
+	static void WaitFor(std::atomic<int>& counter, int expected)
+	{
+		while(counter.load() < expected)
+			std::this_thread::yield();
+	}
+
+	TEST_CLASS(FenceAwaiterTests)
+	{
+	public:
+		TEST_METHOD(CompletedFencesDoNotSuspend)
+		{
+			std::atomic<int> resumed = 0;
+			FakeAwaiterService service{ nullptr };
+			FakeFence fence;
+			service.GetBackend().Signal(fence, 4);
+
+			AwaitFence(service, fence, 4, resumed);
+			Assert::AreEqual(1, resumed.load());
+		}
+
+		TEST_METHOD(ResumesInFenceOrder)
+		{
+			ResumeLog log;
+			FakeAwaiterService service{ nullptr };
+			FakeFence first;
+			FakeFence second;
+
+			AwaitFenceLogged(service, first, 1, 0, log);
+			AwaitFenceLogged(service, first, 2, 1, log);
+			AwaitFenceLogged(service, second, 1, 2, log);
+			Assert::AreEqual(0, log.count.load());
+
+			service.GetBackend().Signal(first, 1);
+			WaitFor(log.count, 1);
+			service.GetBackend().Signal(second, 1);
+			WaitFor(log.count, 2);
+			Assert::AreEqual(2, log.count.load());
+
+			service.GetBackend().Signal(first, 2);
+			WaitFor(log.count, 3);
+			Assert::IsTrue(log.order == std::vector<int>{ 0, 2, 1 });
+		}
+
+		TEST_METHOD(ResumesThroughExecutor)
+		{
+			std::atomic<int> resumed = 0;
+			std::atomic<int> executed = 0;
+			FakeAwaiterService service{ [&](std::coroutine_handle<> handle) { executed++; handle.resume(); } };
+			FakeFence fence;
+
+			AwaitFence(service, fence, 1, resumed);
+			service.GetBackend().Signal(fence, 1);
+			WaitFor(resumed, 1);
+			Assert::AreEqual(1, executed.load());
+		}
+
+		TEST_METHOD(ExecutorFailuresAreKept)
+		{
+			std::atomic<int> resumed = 0;
+			FakeAwaiterService service{ [&](std::coroutine_handle<> handle) { handle.resume(); throw std::runtime_error("Executor failed"); } };
+			FakeFence fence;
+			Assert::IsTrue(service.TakeFailure() == nullptr);
+
+			AwaitFence(service, fence, 1, resumed);
+			service.GetBackend().Signal(fence, 1);
+			WaitFor(resumed, 1);
+
+			std::exception_ptr failure;
+			while(!(failure = service.TakeFailure()))
+				std::this_thread::yield();
+			Assert::ExpectException<std::runtime_error>([&] { std::rethrow_exception(failure); });
+
+			//The waiter thread survived the exception
+			AwaitFence(service, fence, 2, resumed);
+			service.GetBackend().Signal(fence, 2);
+			WaitFor(resumed, 2);
+		}
+
+		TEST_METHOD(WaitFailuresAreRethrownFromCoAwait)
+		{
+			std::atomic<int> failed = 0;
+			FakeAwaiterService service{ nullptr };
+			FakeFence fence;
+			service.GetBackend().failWaits = true;
+
+			AwaitFenceCatching(service, fence, 1, failed);
+			AwaitFenceCatching(service, fence, 2, failed);
+			WaitFor(failed, 2);
+			Assert::IsTrue(service.TakeFailure() == nullptr);
+		}
+	};
+}
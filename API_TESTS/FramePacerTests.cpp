@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <dxgi.h>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+import TypedDXGI;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	//Stands in for the swap chain, queue and fence. Time is counted in milliseconds
+	class FakePacingBackend
+	{
+	public:
+		UINT maximumFrameLatency = 0;
+		std::deque<DWORD> frameLatencyResults;
+		int frameLatencyWaits = 0;
+		std::vector<UINT64> signaled;
+		std::vector<UINT64> fenceWaits;
+		UINT presentCount = 0;
+		bool statisticsAvailable = true;
+		DXGI_FRAME_STATISTICS frameStatistics{};
+		LONGLONG time = 0;
+
+		void SetMaximumFrameLatency(UINT latency) { maximumFrameLatency = latency; }
+
+		DWORD WaitForFrameLatency(DWORD)
+		{
+			frameLatencyWaits++;
+			if(frameLatencyResults.empty())
+				return WAIT_OBJECT_0;
+
+			const DWORD result = frameLatencyResults.front();
+			frameLatencyResults.pop_front();
+			return result;
+		}
+
+		void Signal(UINT64 value) { signaled.push_back(value); }
+		void WaitForFence(UINT64 value) { fenceWaits.push_back(value); }
+		void Present(UINT, UINT) { presentCount++; }
+		UINT GetLastPresentCount() { return presentCount; }
+		UINT GetCurrentBackBufferIndex() { return presentCount % 3; }
+
+		bool GetFrameStatistics(DXGI_FRAME_STATISTICS& statistics)
+		{
+			statistics = frameStatistics;
+			return statisticsAvailable;
+		}
+
+		LARGE_INTEGER GetTime()
+		{
+			LARGE_INTEGER result;
+			result.QuadPart = time;
+			return result;
+		}
+
+		LARGE_INTEGER GetTimeFrequency()
+		{
+			LARGE_INTEGER result;
+			result.QuadPart = 1000;
+			return result;
+		}
+
+		//Reports the present as scanned out at the given time
+		void Display(UINT present, LONGLONG syncTime)
+		{
+			frameStatistics.PresentCount = present;
+			frameStatistics.SyncQPCTime.QuadPart = syncTime;
+		}
+	};
+
+	using FakeFramePacer = DXGI::BasicFramePacer<int, FakePacingBackend>;
+
+	TEST_CLASS(FramePacerTests)
+	{
+	public:
+		TEST_METHOD(SlotsWaitForTheirPreviousFrame)
+		{
+			FakeFramePacer pacer{ 2, 1 };
+			Assert::AreEqual(1u, pacer.GetBackend().maximumFrameLatency);
+
+			for(int i = 0; i < 5; i++)
+			{
+				FakeFramePacer::Frame frame = pacer.BeginFrame();
+				Assert::AreEqual(static_cast<UINT>(i % 2), frame.slotIndex);
+				Assert::AreEqual(static_cast<UINT>(i % 3), frame.backBufferIndex);
+				frame.slot = i;
+				pacer.EndFrame(1);
+			}
+
+			//Every frame waits for the one which last used its slot
+			Assert::IsTrue(pacer.GetBackend().fenceWaits == std::vector<UINT64>{ 0, 0, 1, 2, 3 });
+			Assert::IsTrue(pacer.GetBackend().signaled == std::vector<UINT64>{ 1, 2, 3, 4, 5 });
+			Assert::AreEqual(4, pacer.GetSlot(0));
+			Assert::AreEqual(3, pacer.GetSlot(1));
+			Assert::AreEqual<UINT64>(5, pacer.GetStatistics().framesPresented);
+
+			pacer.WaitForIdle();
+			Assert::AreEqual<UINT64>(5, pacer.GetBackend().fenceWaits.back());
+		}
+
+		TEST_METHOD(RejectsEmptyConfigurations)
+		{
+			Assert::ExpectException<std::invalid_argument>([] { FakeFramePacer pacer{ 0, 1 }; });
+			Assert::ExpectException<std::invalid_argument>([] { FakeFramePacer pacer{ 2, 0 }; });
+		}
+
+		TEST_METHOD(FrameLatencyWaitRetriesAfterApcsAndCountsTimeouts)
+		{
+			FakeFramePacer pacer{ 2, 1 };
+			pacer.GetBackend().frameLatencyResults = { WAIT_IO_COMPLETION, WAIT_IO_COMPLETION, WAIT_OBJECT_0, WAIT_TIMEOUT };
+
+			pacer.BeginFrame();
+			pacer.EndFrame(1);
+			Assert::AreEqual(3, pacer.GetBackend().frameLatencyWaits);
+			Assert::AreEqual<UINT64>(0, pacer.GetStatistics().frameLatencyTimeouts);
+
+			pacer.BeginFrame();
+			pacer.EndFrame(1);
+			Assert::AreEqual(4, pacer.GetBackend().frameLatencyWaits);
+			Assert::AreEqual<UINT64>(1, pacer.GetStatistics().frameLatencyTimeouts);
+		}
+
+		TEST_METHOD(StatisticsMatchPresentsToTheirFrameStart)
+		{
+			FakeFramePacer pacer{ 2, 1 };
+			FakePacingBackend& backend = pacer.GetBackend();
+
+			//Nothing has been displayed yet
+			backend.time = 100;
+			pacer.BeginFrame();
+			pacer.EndFrame(1);
+			Assert::AreEqual(0u, pacer.GetStatistics().queuedPresents);
+			Assert::AreEqual(0.0, pacer.GetStatistics().lastLatencyMilliseconds);
+
+			backend.time = 200;
+			pacer.BeginFrame();
+			backend.Display(1, 130);
+			pacer.EndFrame(1);
+			Assert::AreEqual(1u, pacer.GetStatistics().queuedPresents);
+			Assert::AreEqual(30.0, pacer.GetStatistics().lastLatencyMilliseconds);
+			Assert::AreEqual(30.0, pacer.GetStatistics().averageLatencyMilliseconds);
+
+			backend.time = 300;
+			pacer.BeginFrame();
+			backend.Display(2, 250);
+			pacer.EndFrame(1);
+			Assert::AreEqual(50.0, pacer.GetStatistics().lastLatencyMilliseconds);
+			Assert::AreEqual(31.25, pacer.GetStatistics().averageLatencyMilliseconds);
+
+			//The same statistics again only update the queue depth
+			pacer.BeginFrame();
+			pacer.EndFrame(1);
+			Assert::AreEqual(2u, pacer.GetStatistics().queuedPresents);
+			Assert::AreEqual(31.25, pacer.GetStatistics().averageLatencyMilliseconds);
+
+			//Present 1's record was overwritten by present 5, so it can't be matched anymore
+			pacer.BeginFrame();
+			backend.Display(1, 1000);
+			pacer.EndFrame(1);
+			Assert::AreEqual(4u, pacer.GetStatistics().queuedPresents);
+			Assert::AreEqual(50.0, pacer.GetStatistics().lastLatencyMilliseconds);
+
+			backend.statisticsAvailable = false;
+			pacer.BeginFrame();
+			backend.Display(6, 1000);
+			pacer.EndFrame(1);
+			Assert::AreEqual(4u, pacer.GetStatistics().queuedPresents);
+			Assert::AreEqual(50.0, pacer.GetStatistics().lastLatencyMilliseconds);
+		}
+	};
+}
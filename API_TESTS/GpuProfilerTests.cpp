@@ -0,0 +1,55 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <climits>
+#include <string>
+#include <vector>
+
+import TypedD3D12;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	TEST_CLASS(GpuProfilerTests)
+	{
+	public:
+		TEST_METHOD(ChromeTraceContainsCompleteEvents)
+		{
+			std::vector<D3D12::GpuTiming> timings
+			{
+				{ .name = "Frame", .depth = 0, .frame = 1, .beginMicroseconds = 100, .durationMicroseconds = 50 },
+				{ .name = "Shadow \"pass\"", .depth = 1, .frame = 1, .beginMicroseconds = 110, .durationMicroseconds = 20.5 }
+			};
+
+			std::string trace = D3D12::WriteChromeTrace(timings);
+			Assert::AreEqual<size_t>(0, trace.find("{\"traceEvents\":["));
+			Assert::AreNotEqual(std::string::npos, trace.find("\"name\":\"Frame\",\"cat\":\"gpu\",\"ph\":\"X\""));
+			Assert::AreNotEqual(std::string::npos, trace.find("\"name\":\"Shadow \\\"pass\\\"\""));
+			Assert::AreNotEqual(std::string::npos, trace.find("\"ts\":110.000,\"dur\":20.500"));
+		}
+
+		TEST_METHOD(NestedScopesNeverOverrunTheBudget)
+		{
+			D3D12::TimestampQueryBudget budget{ 4 };
+
+			Assert::AreEqual(0u, budget.BeginScope());
+			Assert::AreEqual(1u, budget.BeginScope());
+
+			//Two queries are left, but both are owed to the ends of the open scopes
+			Assert::AreEqual(UINT_MAX, budget.BeginScope());
+			Assert::AreEqual(2u, budget.EndScope());
+			Assert::AreEqual(3u, budget.EndScope());
+			Assert::AreEqual(4u, budget.GetUsedCount());
+			Assert::AreEqual(UINT_MAX, budget.BeginScope());
+
+			budget.Reset();
+			Assert::AreEqual(0u, budget.BeginScope());
+		}
+
+		TEST_METHOD(EmptyChromeTraceIsValid)
+		{
+			Assert::AreEqual(std::string("{\"traceEvents\":[],\"displayTimeUnit\":\"ms\"}"), D3D12::WriteChromeTrace({}));
+		}
+	};
+}
@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <d3d12.h>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+import TypedD3D12;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	TEST_CLASS(HeapAllocatorTests)
+	{
+	public:
+		TEST_METHOD(TLSFAlignsAndCoalesces)
+		{
+			D3D12::TLSFAllocator allocator{ 1024 * 1024 };
+
+			std::optional<D3D12::TLSFAllocator::Allocation> small = allocator.Allocate(100, 1);
+			std::optional<D3D12::TLSFAllocator::Allocation> aligned = allocator.Allocate(4096, 65536);
+			Assert::IsTrue(small.has_value());
+			Assert::IsTrue(aligned.has_value());
+			Assert::AreEqual<UINT64>(0, aligned->offset % 65536);
+			Assert::IsTrue(aligned->offset >= small->offset + small->size || aligned->offset + aligned->size <= small->offset);
+
+			allocator.Free(*small);
+			allocator.Free(*aligned);
+			Assert::IsTrue(allocator.IsEmpty());
+			Assert::AreEqual<UINT64>(allocator.GetCapacity(), allocator.GetFreeSize());
+
+			std::optional<D3D12::TLSFAllocator::Allocation> whole = allocator.Allocate(allocator.GetCapacity());
+			Assert::IsTrue(whole.has_value());
+			Assert::IsFalse(allocator.Allocate(1).has_value());
+		}
+
+		TEST_METHOD(TLSFReusesFreedRanges)
+		{
+			D3D12::TLSFAllocator allocator{ 4 * 65536 };
+
+			std::vector<D3D12::TLSFAllocator::Allocation> allocations;
+			for(int i = 0; i < 4; i++)
+				allocations.push_back(*allocator.Allocate(65536, 65536));
+			Assert::IsFalse(allocator.Allocate(65536, 65536).has_value());
+
+			allocator.Free(allocations[1]);
+			allocator.Free(allocations[2]);
+
+			std::optional<D3D12::TLSFAllocator::Allocation> merged = allocator.Allocate(2 * 65536, 65536);
+			Assert::IsTrue(merged.has_value());
+			Assert::AreEqual<UINT64>(allocations[1].offset, merged->offset);
+		}
+
+		TEST_METHOD(TLSFFindsBlocksNearCapacity)
+		{
+			constexpr UINT64 megabyte = 1024 * 1024;
+
+			//Both heaps are larger than the request but share its size class, so rounding the request up alone misses them
+			D3D12::TLSFAllocator heap{ 260 * megabyte };
+			std::optional<D3D12::TLSFAllocator::Allocation> aligned = heap.Allocate(258 * megabyte, 65536);
+			Assert::IsTrue(aligned.has_value());
+			Assert::AreEqual<UINT64>(0, aligned->offset % 65536);
+
+			D3D12::TLSFAllocator full{ 1000 * megabyte };
+			Assert::IsTrue(full.Allocate(1000 * megabyte).has_value());
+			Assert::IsFalse(full.Allocate(1).has_value());
+		}
+
+		TEST_METHOD(SuballocatorAddsHeapsWhenFull)
+		{
+			constexpr UINT64 heapSize = 4 * 1024 * 1024;
+			D3D12::HeapSuballocator suballocator{ heapSize };
+			D3D12_RESOURCE_ALLOCATION_INFO info{ .SizeInBytes = heapSize / 2, .Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+
+			D3D12::HeapAllocation first = suballocator.Allocate(info, D3D12::HeapCategory::Universal);
+			D3D12::HeapAllocation second = suballocator.Allocate(info, D3D12::HeapCategory::Universal);
+			D3D12::HeapAllocation third = suballocator.Allocate(info, D3D12::HeapCategory::Universal);
+
+			Assert::AreEqual<UINT32>(0, first.heapIndex);
+			Assert::AreEqual<UINT32>(0, second.heapIndex);
+			Assert::AreEqual<UINT32>(1, third.heapIndex);
+			Assert::AreEqual<UINT32>(2, suballocator.GetHeapCount(D3D12::HeapCategory::Universal));
+
+			suballocator.Free(second);
+			D3D12::HeapAllocation fourth = suballocator.Allocate(info, D3D12::HeapCategory::Universal);
+			Assert::AreEqual<UINT32>(0, fourth.heapIndex);
+			Assert::AreEqual(second.GetOffset(), fourth.GetOffset());
+
+			D3D12_RESOURCE_ALLOCATION_INFO large{ .SizeInBytes = heapSize * 3, .Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+			D3D12::HeapAllocation oversized = suballocator.Allocate(large, D3D12::HeapCategory::Universal);
+			Assert::AreEqual<UINT32>(2, oversized.heapIndex);
+			Assert::IsTrue(suballocator.GetHeap(D3D12::HeapCategory::Universal, 2).GetCapacity() >= large.SizeInBytes);
+		}
+
+		TEST_METHOD(Tier1SeparatesHeapCategories)
+		{
+			D3D12_RESOURCE_DESC buffer{ .Dimension = D3D12_RESOURCE_DIMENSION_BUFFER };
+			D3D12_RESOURCE_DESC texture{ .Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D };
+			D3D12_RESOURCE_DESC renderTarget{ .Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D, .Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET };
+
+			Assert::IsTrue(D3D12::GetHeapCategory(buffer, D3D12_RESOURCE_HEAP_TIER_1) == D3D12::HeapCategory::Buffers);
+			Assert::IsTrue(D3D12::GetHeapCategory(texture, D3D12_RESOURCE_HEAP_TIER_1) == D3D12::HeapCategory::NonRenderTargetTextures);
+			Assert::IsTrue(D3D12::GetHeapCategory(renderTarget, D3D12_RESOURCE_HEAP_TIER_1) == D3D12::HeapCategory::RenderTargetTextures);
+			Assert::IsTrue(D3D12::GetHeapCategory(renderTarget, D3D12_RESOURCE_HEAP_TIER_2) == D3D12::HeapCategory::Universal);
+
+			D3D12::HeapSuballocator suballocator{ 4 * 1024 * 1024 };
+			D3D12_RESOURCE_ALLOCATION_INFO info{ .SizeInBytes = 65536, .Alignment = 65536 };
+			suballocator.Allocate(info, D3D12::GetHeapCategory(buffer, D3D12_RESOURCE_HEAP_TIER_1));
+			suballocator.Allocate(info, D3D12::GetHeapCategory(texture, D3D12_RESOURCE_HEAP_TIER_1));
+
+			Assert::AreEqual<UINT32>(1, suballocator.GetHeapCount(D3D12::HeapCategory::Buffers));
+			Assert::AreEqual<UINT32>(1, suballocator.GetHeapCount(D3D12::HeapCategory::NonRenderTargetTextures));
+			Assert::AreEqual<UINT32>(0, suballocator.GetHeapCount(D3D12::HeapCategory::RenderTargetTextures));
+		}
+
+		TEST_METHOD(ResourceDescKeysIgnorePadding)
+		{
+			D3D12_RESOURCE_DESC first;
+			D3D12_RESOURCE_DESC second;
+			std::memset(&first, 0x00, sizeof(first));
+			std::memset(&second, 0xFF, sizeof(second));
+
+			for(D3D12_RESOURCE_DESC* desc : { &first, &second })
+			{
+				desc->Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+				desc->Alignment = 0;
+				desc->Width = 65536;
+				desc->Height = 1;
+				desc->DepthOrArraySize = 1;
+				desc->MipLevels = 1;
+				desc->Format = DXGI_FORMAT_UNKNOWN;
+				desc->SampleDesc = { 1, 0 };
+				desc->Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+				desc->Flags = D3D12_RESOURCE_FLAG_NONE;
+			}
+			second.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+			Assert::IsTrue(D3D12::MakeResourceDescKey(first) == D3D12::MakeResourceDescKey(second));
+
+			second.Width *= 2;
+			Assert::IsFalse(D3D12::MakeResourceDescKey(first) == D3D12::MakeResourceDescKey(second));
+		}
+	};
+}
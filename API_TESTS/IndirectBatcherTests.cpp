@@ -0,0 +1,83 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <d3d12.h>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+import TypedD3D12;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	TEST_CLASS(IndirectBatcherTests)
+	{
+	public:
+		static D3D12::QueuedDraw MakeDraw(UINT_PTR pipelineState, D3D12_GPU_VIRTUAL_ADDRESS indexBuffer, UINT64 material = 0)
+		{
+			D3D12::QueuedDraw draw;
+			draw.rootSignature = reinterpret_cast<ID3D12RootSignature*>(16);
+			draw.pipelineState = reinterpret_cast<ID3D12PipelineState*>(pipelineState * 16);
+			draw.indexBuffer = { indexBuffer, 1024, DXGI_FORMAT_R16_UINT };
+			draw.material.ptr = material;
+			return draw;
+		}
+
+		TEST_METHOD(RunsSplitWhereBoundStateChanges)
+		{
+			std::vector<D3D12::QueuedDraw> draws
+			{
+				MakeDraw(1, 0x1000), MakeDraw(1, 0x1000), MakeDraw(1, 0x1000), MakeDraw(1, 0x1000),
+				MakeDraw(2, 0x1000),
+				MakeDraw(2, 0x2000), MakeDraw(2, 0x2000, 1), MakeDraw(2, 0x2000, 2),
+			};
+
+			//Without a material parameter the material handles don't split runs
+			std::vector<D3D12::DrawRun> runs = D3D12::PlanIndirectBatches(draws, {}, 3);
+			Assert::AreEqual<size_t>(3, runs.size());
+			Assert::AreEqual(4u, runs[0].count);
+			Assert::IsTrue(runs[0].indirect);
+			Assert::AreEqual(1u, runs[1].count);
+			Assert::IsFalse(runs[1].indirect);
+			Assert::AreEqual(3u, runs[2].count);
+			Assert::IsTrue(runs[2].indirect);
+
+			runs = D3D12::PlanIndirectBatches(draws, { .materialRootParameter = 0 }, 3);
+			Assert::AreEqual<size_t>(5, runs.size());
+			Assert::IsFalse(runs[2].indirect);
+		}
+
+		TEST_METHOD(ArgumentsFollowTheCommandSignatureLayout)
+		{
+			const D3D12::IndirectBatchLayout layout{ .constantsRootParameter = 2, .rootConstantsParameter = 1, .rootConstantCount = 2 };
+			const std::vector<D3D12_INDIRECT_ARGUMENT_DESC> descs = layout.MakeArgumentDescs();
+			Assert::AreEqual<size_t>(3, descs.size());
+			Assert::IsTrue(descs[0].Type == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT);
+			Assert::AreEqual(2u, descs[0].Constant.Num32BitValuesToSet);
+			Assert::IsTrue(descs[1].Type == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW);
+			Assert::IsTrue(descs[2].Type == D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED);
+			Assert::AreEqual<UINT>(2 * 4 + 8 + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS), layout.ByteStride());
+
+			D3D12::QueuedDraw draw = MakeDraw(1, 0x1000);
+			draw.constants = 0xABCD'0000;
+			draw.arguments = { 36, 1, 6, -2, 0 };
+			const std::array<UINT32, 2> rootConstants{ 7, 9 };
+
+			std::vector<std::byte> buffer(layout.ByteStride());
+			Assert::IsTrue(D3D12::WriteIndirectArguments(buffer.data(), layout, draw, rootConstants) == buffer.data() + buffer.size());
+
+			UINT32 writtenConstants[2];
+			D3D12_GPU_VIRTUAL_ADDRESS writtenAddress;
+			D3D12_DRAW_INDEXED_ARGUMENTS writtenArguments;
+			std::memcpy(writtenConstants, buffer.data(), sizeof(writtenConstants));
+			std::memcpy(&writtenAddress, buffer.data() + 8, sizeof(writtenAddress));
+			std::memcpy(&writtenArguments, buffer.data() + 16, sizeof(writtenArguments));
+			Assert::AreEqual(9u, writtenConstants[1]);
+			Assert::AreEqual<UINT64>(0xABCD'0000, writtenAddress);
+			Assert::AreEqual(-2, writtenArguments.BaseVertexLocation);
+		}
+	};
+}
@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <atomic>
+#include <cstdint>
+#include <source_location>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+import TypedD3D12;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	static void RecordInstrumentedCall()
+	{
+		Instrumentation::AddArgumentCount(2);
+		Instrumentation::CallScope scope{ std::source_location::current() };
+	}
+
+	static const Instrumentation::CallStatistics* FindInstrumentedCall(const std::vector<Instrumentation::CallStatistics>& statistics)
+	{
+		for(const Instrumentation::CallStatistics& call : statistics)
+		{
+			if(std::string_view(call.function).find("RecordInstrumentedCall") != std::string_view::npos)
+				return &call;
+		}
+		return nullptr;
+	}
+
+	TEST_CLASS(InstrumentationTests)
+	{
+	public:
+		TEST_METHOD(CallStatisticsAggregateEveryThread)
+		{
+			Instrumentation::ResetCallStatistics();
+			RecordInstrumentedCall();
+			RecordInstrumentedCall();
+
+			std::atomic<bool> recorded = false;
+			std::atomic<bool> exit = false;
+			std::thread worker{ [&]
+			{
+				for(int i = 0; i < 3; i++)
+					RecordInstrumentedCall();
+				recorded = true;
+				while(!exit)
+					std::this_thread::yield();
+			} };
+
+			while(!recorded)
+				std::this_thread::yield();
+
+			//The worker is still running, so its calls are read from its own recorder
+			std::vector<Instrumentation::CallStatistics> statistics = Instrumentation::GetCallStatistics();
+			const Instrumentation::CallStatistics* call = FindInstrumentedCall(statistics);
+			Assert::IsNotNull(call);
+			Assert::AreEqual<std::uint64_t>(5, call->calls);
+			Assert::AreEqual<std::uint64_t>(Instrumentation::enabled ? 10 : 0, call->argumentCount);
+
+			//Calls of exited threads are kept
+			exit = true;
+			worker.join();
+			statistics = Instrumentation::GetCallStatistics();
+			call = FindInstrumentedCall(statistics);
+			Assert::IsNotNull(call);
+			Assert::AreEqual<std::uint64_t>(5, call->calls);
+
+			statistics = Instrumentation::GetThreadCallStatistics();
+			call = FindInstrumentedCall(statistics);
+			Assert::IsNotNull(call);
+			Assert::AreEqual<std::uint64_t>(2, call->calls);
+
+			Instrumentation::ResetCallStatistics();
+			Assert::IsNull(FindInstrumentedCall(Instrumentation::GetCallStatistics()));
+			Assert::IsNull(FindInstrumentedCall(Instrumentation::GetThreadCallStatistics()));
+		}
+	};
+}
@@ -0,0 +1,92 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <d3d11_4.h>
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+import TypedD3D11;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	TEST_CLASS(RenderThreadQueueTests)
+	{
+	public:
+		TEST_METHOD(BatchesRunInSubmissionOrder)
+		{
+			D3D11::RenderThreadQueue queue{ nullptr };
+			D3D11::RenderThreadQueue::Recorder first = queue.CreateRecorder();
+			D3D11::RenderThreadQueue::Recorder second = queue.CreateRecorder();
+
+			std::vector<int> order;
+			first.Enqueue([&](Wrapper<ID3D11DeviceContext>&) { order.push_back(1); });
+			second.Enqueue([&](Wrapper<ID3D11DeviceContext>&) { order.push_back(2); });
+			second.Enqueue([&](Wrapper<ID3D11DeviceContext>&) { order.push_back(3); });
+			second.Submit();
+			first.Submit();
+
+			Assert::AreEqual<size_t>(3, queue.Drain());
+			Assert::IsTrue(std::vector<int>{ 2, 3, 1 } == order);
+			Assert::AreEqual<size_t>(0, queue.Drain());
+		}
+
+		TEST_METHOD(CommandsAreDestroyedAfterRunning)
+		{
+			D3D11::RenderThreadQueue queue{ nullptr };
+			D3D11::RenderThreadQueue::Recorder recorder = queue.CreateRecorder();
+			auto captured = std::make_shared<int>(0);
+
+			//Bigger than a chunk, so it gets a chunk of its own
+			recorder.Enqueue([captured, padding = std::array<char, 100'000>{}](Wrapper<ID3D11DeviceContext>&) { (*captured)++; });
+			recorder.Submit();
+			Assert::AreEqual<long>(2, captured.use_count());
+
+			queue.Drain();
+			Assert::AreEqual(1, *captured);
+			Assert::AreEqual<long>(1, captured.use_count());
+		}
+
+		TEST_METHOD(UndrainedCommandsAreDestroyedWithoutRunning)
+		{
+			auto captured = std::make_shared<int>(0);
+			{
+				D3D11::RenderThreadQueue queue{ nullptr };
+				D3D11::RenderThreadQueue::Recorder recorder = queue.CreateRecorder();
+				recorder.Enqueue([captured](Wrapper<ID3D11DeviceContext>&) { (*captured)++; });
+				recorder.Submit();
+			}
+
+			Assert::AreEqual(0, *captured);
+			Assert::AreEqual<long>(1, captured.use_count());
+		}
+
+		TEST_METHOD(ThrowingCommandsDiscardTheRestOfTheDrain)
+		{
+			D3D11::RenderThreadQueue queue{ nullptr };
+			D3D11::RenderThreadQueue::Recorder first = queue.CreateRecorder();
+			D3D11::RenderThreadQueue::Recorder second = queue.CreateRecorder();
+			auto captured = std::make_shared<int>(0);
+
+			first.Enqueue([captured](Wrapper<ID3D11DeviceContext>&) { (*captured)++; });
+			first.Enqueue([captured](Wrapper<ID3D11DeviceContext>&) { throw std::runtime_error("Failed"); });
+			first.Enqueue([captured](Wrapper<ID3D11DeviceContext>&) { (*captured)++; });
+			first.Submit();
+			second.Enqueue([captured](Wrapper<ID3D11DeviceContext>&) { (*captured)++; });
+			second.Submit();
+
+			Assert::ExpectException<std::runtime_error>([&] { queue.Drain(); });
+			Assert::AreEqual(1, *captured);
+			Assert::AreEqual<long>(1, captured.use_count());
+
+			//Both batches went back to their recorders and can be recorded into again
+			first.Enqueue([captured](Wrapper<ID3D11DeviceContext>&) { (*captured)++; });
+			first.Submit();
+			Assert::AreEqual<size_t>(1, queue.Drain());
+			Assert::AreEqual(2, *captured);
+		}
+	};
+}
@@ -0,0 +1,147 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "soa_vector.h"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace APITESTS
+{
+	//Counts live instances, and throws from the constructor once the countdown runs out
+	struct CountedElement
+	{
+		static inline int live = 0;
+		static inline int constructionsBeforeThrow = -1;
+
+		int value = 0;
+
+		CountedElement() { Construct(); }
+		CountedElement(int value) : value{ value } { Construct(); }
+		CountedElement(const CountedElement& other) : value{ other.value } { Construct(); }
+		CountedElement(CountedElement&& other) noexcept : value{ other.value } { live++; }
+		CountedElement& operator=(const CountedElement&) = default;
+		CountedElement& operator=(CountedElement&&) noexcept = default;
+		~CountedElement() { live--; }
+
+	private:
+		void Construct()
+		{
+			if(constructionsBeforeThrow == 0)
+				throw std::runtime_error("Construction failed");
+			if(constructionsBeforeThrow > 0)
+				constructionsBeforeThrow--;
+			live++;
+		}
+	};
+
+	TEST_CLASS(SoaVectorTests)
+	{
+	public:
+		TEST_METHOD_INITIALIZE(ResetCounters)
+		{
+			CountedElement::live = 0;
+			CountedElement::constructionsBeforeThrow = -1;
+		}
+
+		TEST_METHOD(GrowthKeepsEveryColumn)
+		{
+			xk::soa_vector<int, std::string, std::unique_ptr<int>> vector;
+			for(int i = 0; i < 1000; i++)
+				vector.emplace_back(i, std::to_string(i), std::make_unique<int>(i * 2));
+
+			Assert::AreEqual<size_t>(1000, vector.size());
+			Assert::IsTrue(vector.capacity() >= vector.size());
+			for(int i = 0; i < 1000; i++)
+			{
+				auto [id, name, pointer] = vector[i];
+				Assert::AreEqual(i, id);
+				Assert::AreEqual(std::to_string(i), name);
+				Assert::AreEqual(i * 2, *pointer);
+			}
+
+			//Every column is aligned to a cache line
+			Assert::AreEqual<size_t>(0, reinterpret_cast<uintptr_t>(vector.data<1>()) % 64);
+			Assert::AreEqual<size_t>(0, reinterpret_cast<uintptr_t>(vector.data<2>()) % 64);
+
+			vector.swap_remove(0);
+			Assert::AreEqual<size_t>(999, vector.size());
+			Assert::AreEqual(999, std::get<0>(vector[0]));
+			Assert::AreEqual(std::string("999"), std::get<1>(vector[0]));
+
+			vector.resize(10);
+			vector.shrink_to_fit();
+			Assert::AreEqual<size_t>(10, vector.capacity());
+			Assert::AreEqual(std::string("9"), std::get<1>(vector.back()));
+		}
+
+		TEST_METHOD(CopiesAndMovesOwnTheirElements)
+		{
+			xk::soa_vector<std::string, CountedElement> original;
+			original.emplace_back("first", 1);
+			original.emplace_back("second", 2);
+
+			xk::soa_vector<std::string, CountedElement> copy = original;
+			Assert::AreEqual(4, CountedElement::live);
+			std::get<0>(copy[0]) = "changed";
+			Assert::AreEqual(std::string("first"), std::get<0>(original[0]));
+
+			xk::soa_vector<std::string, CountedElement> moved = std::move(original);
+			Assert::IsTrue(original.empty());
+			Assert::AreEqual<size_t>(2, moved.size());
+			Assert::AreEqual(2, std::get<1>(moved[1]).value);
+
+			copy = moved;
+			Assert::AreEqual(std::string("first"), std::get<0>(copy[0]));
+			Assert::AreEqual(4, CountedElement::live);
+
+			copy.clear();
+			moved = {};
+			Assert::AreEqual(0, CountedElement::live);
+		}
+
+		TEST_METHOD(ThrowingConstructorsLeaveNothingBehind)
+		{
+			CountedElement::constructionsBeforeThrow = 5;
+			Assert::ExpectException<std::runtime_error>([] { xk::soa_vector<std::string, CountedElement> vector(10); });
+			Assert::AreEqual(0, CountedElement::live);
+
+			CountedElement::constructionsBeforeThrow = -1;
+			xk::soa_vector<std::string, CountedElement> source(4);
+			CountedElement::constructionsBeforeThrow = 2;
+			Assert::ExpectException<std::runtime_error>([&] { xk::soa_vector<std::string, CountedElement> copy = source; });
+			Assert::AreEqual(4, CountedElement::live);
+
+			//A failed emplace leaves the vector as it was
+			CountedElement::constructionsBeforeThrow = 0;
+			Assert::ExpectException<std::runtime_error>([&] { source.emplace_back("fifth", 5); });
+			Assert::AreEqual<size_t>(4, source.size());
+			Assert::AreEqual(4, CountedElement::live);
+		}
+
+		TEST_METHOD(IteratesThroughSpanTupleIterators)
+		{
+			xk::soa_vector<int, float> vector;
+			for(int i = 0; i < 8; i++)
+				vector.emplace_back(i, 0.5f * static_cast<float>(i));
+
+			for(auto [id, weight] : vector)
+				weight += static_cast<float>(id);
+
+			int count = 0;
+			for(xk::soa_vector<int, float>::const_iterator it = std::as_const(vector).begin(); it != std::as_const(vector).end(); ++it, count++)
+			{
+				auto [id, weight] = *it;
+				Assert::AreEqual(1.5f * static_cast<float>(id), weight);
+			}
+			Assert::AreEqual(8, count);
+			Assert::AreEqual(7, std::get<0>(*vector.rbegin()));
+
+			xk::soa_vector<int, float>::view_type view = vector.view();
+			Assert::AreEqual<size_t>(8, view.size());
+			Assert::AreEqual(3.f, std::get<1>(view[2]));
+		}
+	};
+}
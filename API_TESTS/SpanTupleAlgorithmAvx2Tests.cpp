@@ -0,0 +1,9 @@
+#include "pch.h"
+
+//This file is built with /arch:AVX2 so the gather instructions and the 256 bit sums run
+#define SPAN_TUPLE_ALGORITHM_TEST_CLASS SpanTupleAlgorithmAvx2Tests
+#include "SpanTupleAlgorithmTests.h"
+
+#if !defined(XK_SPAN_TUPLE_AVX2)
+#error SpanTupleAlgorithmAvx2Tests.cpp must be built with AVX2 enabled
+#endif
@@ -0,0 +1,6 @@
+#include "pch.h"
+
+//The plain loops every SIMD path falls back to
+#define XK_SPAN_TUPLE_NO_SIMD
+#define SPAN_TUPLE_ALGORITHM_TEST_CLASS SpanTupleAlgorithmScalarTests
+#include "SpanTupleAlgorithmTests.h"
@@ -0,0 +1,5 @@
+#include "pch.h"
+
+//Built with the project's instruction set, which takes the SSE2 paths on x64
+#define SPAN_TUPLE_ALGORITHM_TEST_CLASS SpanTupleAlgorithmTests
+#include "SpanTupleAlgorithmTests.h"
@@ -0,0 +1,199 @@
+#pragma once
+//Shared body of the span_tuple_algorithm tests. Each including translation unit builds it for a different instruction set
+//and names the test class through SPAN_TUPLE_ALGORITHM_TEST_CLASS, so every SIMD path is compared against plain loops
+#include "CppUnitTest.h"
+#include "soa_vector.h"
+#include "span_tuple_algorithm.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <span>
+#include <vector>
+
+#define SPAN_TUPLE_ALGORITHM_TEST_CLASS_NAMED(name) TEST_CLASS(name)
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace APITESTS
+{
+	SPAN_TUPLE_ALGORITHM_TEST_CLASS_NAMED(SPAN_TUPLE_ALGORITHM_TEST_CLASS)
+	{
+		//Counts on both sides of every lane width, so the SIMD loops and the scalar tails are both exercised
+		static constexpr size_t counts[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 33, 1000 };
+
+		//Twelve bytes, so it never takes the SIMD path
+		struct Triple
+		{
+			std::uint32_t x;
+			std::uint32_t y;
+			std::uint32_t z;
+
+			bool operator==(const Triple&) const = default;
+		};
+
+		template<class Ty>
+		static std::vector<Ty> MakeValues(size_t count)
+		{
+			std::vector<Ty> values(count);
+			for(size_t i = 0; i < count; i++)
+			{
+				if constexpr(std::is_same_v<Ty, Triple>)
+					values[i] = Triple{ std::uint32_t(i), std::uint32_t(i * 3), std::uint32_t(i * 7) };
+				else
+					values[i] = static_cast<Ty>((i % 256) * 37 + 11);
+			}
+			return values;
+		}
+
+		//Random indices into a source of sourceCount elements, repeats included
+		static std::vector<std::uint32_t> MakeIndices(size_t count, size_t sourceCount)
+		{
+			std::mt19937 random{ static_cast<std::uint32_t>(count) };
+			std::uniform_int_distribution<std::uint32_t> distribution{ 0, static_cast<std::uint32_t>(sourceCount - 1) };
+			std::vector<std::uint32_t> indices(count);
+			for(std::uint32_t& index : indices)
+				index = distribution(random);
+			return indices;
+		}
+
+		template<class Ty>
+		static void GatherMatchesScalar()
+		{
+			for(size_t count : counts)
+			{
+				const std::vector<Ty> source = MakeValues<Ty>(count + 13);
+				const std::vector<std::uint32_t> indices = MakeIndices(count, source.size());
+
+				std::vector<Ty> expected(count);
+				for(size_t i = 0; i < count; i++)
+					expected[i] = source[indices[i]];
+
+				std::vector<Ty> destination(count);
+				xk::gather(std::span<const Ty>(source), std::span<const std::uint32_t>(indices), std::span<Ty>(destination));
+				Assert::IsTrue(expected == destination);
+			}
+		}
+
+	public:
+		TEST_METHOD(GatherMatchesScalarForFourByteTypes)
+		{
+			GatherMatchesScalar<std::uint32_t>();
+			GatherMatchesScalar<float>();
+		}
+
+		TEST_METHOD(GatherMatchesScalarForEightByteTypes)
+		{
+			GatherMatchesScalar<std::uint64_t>();
+			GatherMatchesScalar<double>();
+		}
+
+		TEST_METHOD(GatherMatchesScalarForOtherTypes)
+		{
+			GatherMatchesScalar<Triple>();
+		}
+
+		TEST_METHOD(ScatterInvertsGather)
+		{
+			for(size_t count : counts)
+			{
+				std::vector<std::uint32_t> order(count);
+				std::iota(order.begin(), order.end(), 0u);
+				std::shuffle(order.begin(), order.end(), std::mt19937{ static_cast<std::uint32_t>(count) });
+
+				std::vector<double> source = MakeValues<double>(count);
+				std::vector<double> scattered(count);
+				xk::scatter(std::span<double>(source), std::span<const std::uint32_t>(order), std::span<double>(scattered));
+				for(size_t i = 0; i < count; i++)
+					Assert::AreEqual(source[i], scattered[order[i]]);
+
+				std::vector<double> gathered(count);
+				xk::gather(std::span<double>(scattered), std::span<const std::uint32_t>(order), std::span<double>(gathered));
+				Assert::IsTrue(source == gathered);
+			}
+		}
+
+		TEST_METHOD(PermuteKeepsRowsTogether)
+		{
+			for(size_t count : counts)
+			{
+				xk::soa_vector<std::uint32_t, double, Triple> source;
+				for(size_t i = 0; i < count; i++)
+					source.emplace_back(std::uint32_t(i), static_cast<double>(i) * 0.25, Triple{ std::uint32_t(i), 0, std::uint32_t(count - i) });
+
+				//Reverse the rows
+				std::vector<std::uint32_t> order(count);
+				for(size_t i = 0; i < count; i++)
+					order[i] = static_cast<std::uint32_t>(count - 1 - i);
+
+				xk::soa_vector<std::uint32_t, double, Triple> destination(count);
+				xk::permute(std::as_const(source).view(), std::span<const std::uint32_t>(order), destination.view());
+				for(size_t i = 0; i < count; i++)
+				{
+					auto [id, weight, triple] = destination[i];
+					Assert::AreEqual(order[i], id);
+					Assert::AreEqual(static_cast<double>(order[i]) * 0.25, weight);
+					Assert::IsTrue(triple == Triple{ order[i], 0, std::uint32_t(count - order[i]) });
+				}
+			}
+		}
+
+		TEST_METHOD(ForEachVisitsEveryRowInOrder)
+		{
+			//The larger count crosses the prefetch threshold
+			for(size_t count : { size_t(0), size_t(5), size_t(17), size_t(20000) })
+			{
+				xk::soa_vector<std::uint32_t, std::uint64_t> vector;
+				for(size_t i = 0; i < count; i++)
+					vector.emplace_back(std::uint32_t(i), std::uint64_t(i) * 3);
+
+				size_t visited = 0;
+				xk::for_each(vector.view(), [&](std::uint32_t& id, std::uint64_t& value)
+				{
+					Assert::AreEqual<size_t>(visited++, id);
+					value += id;
+				});
+
+				Assert::AreEqual(count, visited);
+				for(size_t i = 0; i < count; i++)
+					Assert::AreEqual<std::uint64_t>(i * 4, std::get<1>(vector[i]));
+			}
+		}
+
+		TEST_METHOD(ReduceMatchesScalar)
+		{
+			for(size_t count : counts)
+			{
+				const std::vector<std::int32_t> signedValues = MakeValues<std::int32_t>(count);
+				Assert::AreEqual(std::accumulate(signedValues.begin(), signedValues.end(), std::int32_t(-5)), xk::reduce(std::span(signedValues), std::int32_t(-5)));
+
+				const std::vector<std::uint32_t> unsignedValues = MakeValues<std::uint32_t>(count);
+				Assert::AreEqual(std::accumulate(unsignedValues.begin(), unsignedValues.end(), 7u), xk::reduce(std::span(unsignedValues), 7u));
+
+				//Vectorized float sums are reassociated, exact in this range since every value is a small integer
+				const std::vector<float> floatValues = MakeValues<float>(count);
+				Assert::AreEqual(std::accumulate(floatValues.begin(), floatValues.end(), 0.5f), xk::reduce(std::span(floatValues), 0.5f));
+
+				//Operations and value types without a SIMD path
+				const std::vector<std::uint64_t> wideValues = MakeValues<std::uint64_t>(count);
+				Assert::AreEqual<std::uint64_t>(std::accumulate(wideValues.begin(), wideValues.end(), std::uint64_t(0)), xk::reduce(std::span(wideValues), std::uint64_t(0)));
+				Assert::AreEqual<std::int64_t>(std::accumulate(signedValues.begin(), signedValues.end(), std::int64_t(0)), xk::reduce(std::span(signedValues), std::int64_t(0)));
+				Assert::AreEqual(std::accumulate(unsignedValues.begin(), unsignedValues.end(), 0u, [](std::uint32_t a, std::uint32_t b) { return std::max(a, b); }),
+					xk::reduce(std::span(unsignedValues), 0u, [](std::uint32_t a, std::uint32_t b) { return std::max(a, b); }));
+			}
+		}
+
+		TEST_METHOD(ReduceRoundsFloatsWithinTolerance)
+		{
+			std::vector<float> values(1001);
+			for(size_t i = 0; i < values.size(); i++)
+				values[i] = 1.f / static_cast<float>(i + 1);
+
+			double exact = 0;
+			for(float value : values)
+				exact += value;
+			Assert::AreEqual(exact, static_cast<double>(xk::reduce(std::span(values), 0.f)), 1e-4);
+		}
+	};
+}
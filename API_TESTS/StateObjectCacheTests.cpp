@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <d3d11_4.h>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+import TypedD3D11;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	//A minimal DXBC container holding an input signature chunk followed by a shader chunk
+	static std::vector<std::byte> MakeBytecode(std::string inputSignature, std::string shader)
+	{
+		std::vector<std::byte> bytes(32 + 2 * 4);
+		std::memcpy(bytes.data(), "DXBC", 4);
+		const UINT chunkCount = 2;
+		std::memcpy(bytes.data() + 28, &chunkCount, 4);
+
+		UINT chunkIndex = 0;
+		for(auto [fourcc, data] : { std::pair{ "ISGN", inputSignature }, std::pair{ "SHEX", shader } })
+		{
+			const UINT offset = static_cast<UINT>(bytes.size());
+			const UINT size = static_cast<UINT>(data.size());
+			std::memcpy(bytes.data() + 32 + 4 * chunkIndex++, &offset, 4);
+
+			bytes.resize(offset + 8 + size);
+			std::memcpy(bytes.data() + offset, fourcc, 4);
+			std::memcpy(bytes.data() + offset + 4, &size, 4);
+			std::memcpy(bytes.data() + offset + 8, data.data(), size);
+		}
+		return bytes;
+	}
+
+	TEST_CLASS(StateObjectCacheTests)
+	{
+	public:
+		TEST_METHOD(BlendKeysIgnorePadding)
+		{
+			D3D11_BLEND_DESC first;
+			D3D11_BLEND_DESC second;
+			std::memset(&first, 0x00, sizeof(first));
+			std::memset(&second, 0xFF, sizeof(second));
+
+			for(D3D11_BLEND_DESC* desc : { &first, &second })
+			{
+				desc->AlphaToCoverageEnable = FALSE;
+				desc->IndependentBlendEnable = FALSE;
+				for(D3D11_RENDER_TARGET_BLEND_DESC& renderTarget : desc->RenderTarget)
+				{
+					renderTarget =
+					{
+						TRUE,
+						D3D11_BLEND_SRC_ALPHA, D3D11_BLEND_INV_SRC_ALPHA, D3D11_BLEND_OP_ADD,
+						D3D11_BLEND_ONE, D3D11_BLEND_ZERO, D3D11_BLEND_OP_ADD,
+						D3D11_COLOR_WRITE_ENABLE_ALL
+					};
+				}
+			}
+
+			Assert::IsTrue(D3D11::MakeBlendKey(first) == D3D11::MakeBlendKey(second));
+
+			second.RenderTarget[7].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_RED;
+			Assert::IsFalse(D3D11::MakeBlendKey(first) == D3D11::MakeBlendKey(second));
+		}
+
+		TEST_METHOD(DepthStencilKeysIgnorePadding)
+		{
+			D3D11_DEPTH_STENCIL_DESC first;
+			D3D11_DEPTH_STENCIL_DESC second;
+			std::memset(&first, 0x00, sizeof(first));
+			std::memset(&second, 0xFF, sizeof(second));
+
+			for(D3D11_DEPTH_STENCIL_DESC* desc : { &first, &second })
+			{
+				desc->DepthEnable = TRUE;
+				desc->DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+				desc->DepthFunc = D3D11_COMPARISON_LESS;
+				desc->StencilEnable = FALSE;
+				desc->StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
+				desc->StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
+				desc->FrontFace = { D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS };
+				desc->BackFace = desc->FrontFace;
+			}
+
+			Assert::IsTrue(D3D11::MakeDepthStencilKey(first) == D3D11::MakeDepthStencilKey(second));
+
+			second.DepthFunc = D3D11_COMPARISON_GREATER;
+			Assert::IsFalse(D3D11::MakeDepthStencilKey(first) == D3D11::MakeDepthStencilKey(second));
+		}
+
+		TEST_METHOD(InputLayoutKeysOnlyDependOnTheInputSignature)
+		{
+			std::string semantic = "POSITION";
+			std::string semanticCopy = semantic;
+			D3D11_INPUT_ELEMENT_DESC element{ semantic.c_str(), 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+			D3D11_INPUT_ELEMENT_DESC elementCopy = element;
+			elementCopy.SemanticName = semanticCopy.c_str();
+
+			std::vector<std::byte> vertexShader = MakeBytecode("signature", "first shader");
+			std::vector<std::byte> otherVertexShader = MakeBytecode("signature", "second, longer shader");
+			std::vector<std::byte> otherSignature = MakeBytecode("another signature", "first shader");
+
+			Assert::IsTrue(D3D11::FindInputSignature(vertexShader).size() == 8 + std::string("signature").size());
+			Assert::IsTrue(D3D11::MakeInputLayoutKey({ &element, 1 }, vertexShader) == D3D11::MakeInputLayoutKey({ &elementCopy, 1 }, otherVertexShader));
+			Assert::IsFalse(D3D11::MakeInputLayoutKey({ &element, 1 }, vertexShader) == D3D11::MakeInputLayoutKey({ &element, 1 }, otherSignature));
+		}
+
+		TEST_METHOD(NonDxbcBytecodeIsHashedWhole)
+		{
+			std::vector<std::byte> bytecode(16, std::byte{ 7 });
+			Assert::AreEqual(bytecode.size(), D3D11::FindInputSignature(bytecode).size());
+		}
+	};
+}
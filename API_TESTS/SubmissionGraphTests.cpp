@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <d3d12.h>
+#include <stdexcept>
+
+import TypedD3D12;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	TEST_CLASS(SubmissionGraphTests)
+	{
+	public:
+		TEST_METHOD(SameQueueDependenciesAreImplicit)
+		{
+			D3D12::SubmissionGraph graph;
+			UINT32 first = graph.AddBatch(D3D12_COMMAND_LIST_TYPE_DIRECT);
+			UINT32 second = graph.AddBatch(D3D12_COMMAND_LIST_TYPE_DIRECT, { first });
+
+			D3D12::SubmissionSchedule schedule = graph.Compile();
+			Assert::AreEqual<size_t>(0, schedule.GetWaitCount());
+			Assert::AreEqual<size_t>(0, schedule.GetSignalCount());
+			Assert::AreEqual<UINT64>(2, schedule.batches[second].fenceValue);
+		}
+
+		TEST_METHOD(OnlyLatestDependencyPerQueueIsWaitedOn)
+		{
+			D3D12::SubmissionGraph graph;
+			UINT32 upload0 = graph.AddBatch(D3D12_COMMAND_LIST_TYPE_COPY);
+			UINT32 upload1 = graph.AddBatch(D3D12_COMMAND_LIST_TYPE_COPY);
+			UINT32 compute = graph.AddBatch(D3D12_COMMAND_LIST_TYPE_COMPUTE, { upload0, upload1 });
+
+			D3D12::SubmissionSchedule schedule = graph.Compile();
+			Assert::AreEqual<size_t>(1, schedule.batches[compute].waits.size());
+			Assert::IsTrue(schedule.batches[compute].waits[0].queue == D3D12_COMMAND_LIST_TYPE_COPY);
+			Assert::AreEqual<UINT64>(2, schedule.batches[compute].waits[0].fenceValue);
+			Assert::IsFalse(schedule.batches[upload0].signal);
+			Assert::IsTrue(schedule.batches[upload1].signal);
+		}
+
+		TEST_METHOD(TransitiveWaitsAreRemoved)
+		{
+			D3D12::SubmissionGraph graph;
+			UINT32 upload = graph.AddBatch(D3D12_COMMAND_LIST_TYPE_COPY);
+			UINT32 compute = graph.AddBatch(D3D12_COMMAND_LIST_TYPE_COMPUTE, { upload });
+			UINT32 render = graph.AddBatch(D3D12_COMMAND_LIST_TYPE_DIRECT, { upload, compute });
+			UINT32 present = graph.AddBatch(D3D12_COMMAND_LIST_TYPE_DIRECT, { upload, compute, render });
+
+			D3D12::SubmissionSchedule schedule = graph.Compile();
+			Assert::AreEqual<size_t>(1, schedule.batches[render].waits.size());
+			Assert::IsTrue(schedule.batches[render].waits[0].queue == D3D12_COMMAND_LIST_TYPE_COMPUTE);
+			Assert::AreEqual<size_t>(0, schedule.batches[present].waits.size());
+			Assert::AreEqual<size_t>(2, schedule.GetWaitCount());
+		}
+
+		TEST_METHOD(RejectsForwardDependencies)
+		{
+			D3D12::SubmissionGraph graph;
+			graph.AddBatch(D3D12_COMMAND_LIST_TYPE_DIRECT);
+			Assert::ExpectException<std::invalid_argument>([&] { graph.AddBatch(D3D12_COMMAND_LIST_TYPE_COMPUTE, { 1 }); });
+			Assert::ExpectException<std::invalid_argument>([&] { graph.AddBatch(D3D12_COMMAND_LIST_TYPE_BUNDLE); });
+		}
+	};
+}
@@ -0,0 +1,158 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <d3d12.h>
+#include <stdexcept>
+#include <vector>
+
+import TypedD3D12;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace TypedD3D;
+
+namespace APITESTS
+{
+	constexpr UINT64 transientMegabyte = 1024 * 1024;
+
+	static D3D12::TransientLifetime Lifetime(UINT64 size, UINT firstUse, UINT lastUse, D3D12::HeapCategory category = D3D12::HeapCategory::Universal)
+	{
+		return
+		{
+			.allocationInfo = { .SizeInBytes = size, .Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT },
+			.category = category,
+			.firstUse = firstUse,
+			.lastUse = lastUse
+		};
+	}
+
+	//Resources alive in the same pass must never share memory, and every offset must keep the resource's alignment
+	static void AssertNoLiveOverlap(const std::vector<D3D12::TransientLifetime>& lifetimes, const D3D12::TransientAliasingPlan& plan)
+	{
+		for(size_t i = 0; i < lifetimes.size(); i++)
+		{
+			Assert::AreEqual<UINT64>(0, plan.offsets[i] % lifetimes[i].allocationInfo.Alignment);
+			Assert::IsTrue(plan.offsets[i] + lifetimes[i].allocationInfo.SizeInBytes <= plan.heapSizes[static_cast<size_t>(lifetimes[i].category)]);
+
+			for(size_t j = i + 1; j < lifetimes.size(); j++)
+			{
+				const bool alive = lifetimes[i].firstUse <= lifetimes[j].lastUse && lifetimes[j].firstUse <= lifetimes[i].lastUse;
+				if(!alive || lifetimes[i].category != lifetimes[j].category)
+					continue;
+
+				const bool disjoint = plan.offsets[i] + lifetimes[i].allocationInfo.SizeInBytes <= plan.offsets[j]
+					|| plan.offsets[j] + lifetimes[j].allocationInfo.SizeInBytes <= plan.offsets[i];
+				Assert::IsTrue(disjoint);
+			}
+		}
+	}
+
+	static void AssertAliasing(const D3D12::TransientAliasing& aliasing, UINT pass, UINT before, UINT after)
+	{
+		Assert::AreEqual(pass, aliasing.pass);
+		Assert::AreEqual(before, aliasing.before);
+		Assert::AreEqual(after, aliasing.after);
+	}
+
+	TEST_CLASS(TransientResourcePlannerTests)
+	{
+	public:
+		TEST_METHOD(DisjointLifetimesShareMemory)
+		{
+			const std::vector<D3D12::TransientLifetime> lifetimes
+			{
+				Lifetime(4 * transientMegabyte, 0, 1),
+				Lifetime(2 * transientMegabyte, 2, 3),
+				Lifetime(2 * transientMegabyte, 2, 3),
+				Lifetime(1 * transientMegabyte, 0, 3)
+			};
+
+			const D3D12::TransientAliasingPlan plan = D3D12::PlanTransientAliasing(lifetimes);
+			AssertNoLiveOverlap(lifetimes, plan);
+
+			//The two later resources fit inside the first, the one alive throughout goes past all of them
+			Assert::AreEqual<UINT64>(0, plan.offsets[0]);
+			Assert::AreEqual<UINT64>(0, plan.offsets[1]);
+			Assert::AreEqual<UINT64>(2 * transientMegabyte, plan.offsets[2]);
+			Assert::AreEqual<UINT64>(4 * transientMegabyte, plan.offsets[3]);
+			Assert::AreEqual<UINT64>(5 * transientMegabyte, plan.heapSizes[static_cast<size_t>(D3D12::HeapCategory::Universal)]);
+			Assert::AreEqual<UINT64>(5 * transientMegabyte, plan.GetAliasedSize());
+			Assert::AreEqual<UINT64>(9 * transientMegabyte, plan.unaliasedSize);
+
+			//The first resource shares memory with resources which haven't been used yet, so there is nothing to alias from
+			Assert::AreEqual<size_t>(3, plan.aliasing.size());
+			AssertAliasing(plan.aliasing[0], 0, D3D12::TransientAliasing::noResource, 0);
+			AssertAliasing(plan.aliasing[1], 2, 0, 1);
+			AssertAliasing(plan.aliasing[2], 2, 0, 2);
+		}
+
+		TEST_METHOD(AliasesFromTheLatestPreviousUser)
+		{
+			const std::vector<D3D12::TransientLifetime> lifetimes
+			{
+				Lifetime(2 * transientMegabyte, 0, 0),
+				Lifetime(2 * transientMegabyte, 1, 1),
+				Lifetime(2 * transientMegabyte, 2, 2)
+			};
+
+			const D3D12::TransientAliasingPlan plan = D3D12::PlanTransientAliasing(lifetimes);
+			AssertNoLiveOverlap(lifetimes, plan);
+			Assert::AreEqual<UINT64>(2 * transientMegabyte, plan.GetAliasedSize());
+
+			Assert::AreEqual<size_t>(3, plan.aliasing.size());
+			AssertAliasing(plan.aliasing[0], 0, D3D12::TransientAliasing::noResource, 0);
+			AssertAliasing(plan.aliasing[1], 1, 0, 1);
+			AssertAliasing(plan.aliasing[2], 2, 1, 2);
+		}
+
+		TEST_METHOD(AmbiguousPreviousUsersAliasFromNull)
+		{
+			//The large resource covers the memory of two which both ended in pass 1
+			const std::vector<D3D12::TransientLifetime> lifetimes
+			{
+				Lifetime(4 * transientMegabyte, 2, 3),
+				Lifetime(2 * transientMegabyte, 0, 1),
+				Lifetime(2 * transientMegabyte, 0, 1)
+			};
+
+			const D3D12::TransientAliasingPlan plan = D3D12::PlanTransientAliasing(lifetimes);
+			AssertNoLiveOverlap(lifetimes, plan);
+			Assert::AreEqual<UINT64>(0, plan.offsets[1]);
+			Assert::AreEqual<UINT64>(2 * transientMegabyte, plan.offsets[2]);
+
+			Assert::AreEqual<size_t>(3, plan.aliasing.size());
+			AssertAliasing(plan.aliasing[0], 0, D3D12::TransientAliasing::noResource, 1);
+			AssertAliasing(plan.aliasing[1], 0, D3D12::TransientAliasing::noResource, 2);
+			AssertAliasing(plan.aliasing[2], 2, D3D12::TransientAliasing::noResource, 0);
+		}
+
+		TEST_METHOD(CategoriesNeverShareHeaps)
+		{
+			const std::vector<D3D12::TransientLifetime> lifetimes
+			{
+				Lifetime(transientMegabyte, 0, 0, D3D12::HeapCategory::Buffers),
+				Lifetime(transientMegabyte, 1, 1, D3D12::HeapCategory::RenderTargetTextures),
+				Lifetime(transientMegabyte, 0, 1, D3D12::HeapCategory::RenderTargetTextures)
+			};
+
+			const D3D12::TransientAliasingPlan plan = D3D12::PlanTransientAliasing(lifetimes);
+			AssertNoLiveOverlap(lifetimes, plan);
+			Assert::AreEqual<UINT64>(transientMegabyte, plan.heapSizes[static_cast<size_t>(D3D12::HeapCategory::Buffers)]);
+			Assert::AreEqual<UINT64>(2 * transientMegabyte, plan.heapSizes[static_cast<size_t>(D3D12::HeapCategory::RenderTargetTextures)]);
+			Assert::AreEqual<UINT64>(0, plan.heapSizes[static_cast<size_t>(D3D12::HeapCategory::Universal)]);
+			Assert::IsTrue(plan.aliasing.empty());
+		}
+
+		TEST_METHOD(RejectsInvertedLifetimes)
+		{
+			const std::vector<D3D12::TransientLifetime> lifetimes{ Lifetime(transientMegabyte, 2, 1) };
+			Assert::ExpectException<std::invalid_argument>([&] { D3D12::PlanTransientAliasing(lifetimes); });
+		}
+
+		TEST_METHOD(EmptyPlan)
+		{
+			const D3D12::TransientAliasingPlan plan = D3D12::PlanTransientAliasing({});
+			Assert::IsTrue(plan.offsets.empty());
+			Assert::IsTrue(plan.aliasing.empty());
+			Assert::AreEqual<UINT64>(0, plan.GetAliasedSize());
+		}
+	};
+}
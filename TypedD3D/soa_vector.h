@@ -0,0 +1,381 @@
+//*********************************************************
+//
+// Copyright (c) 2022 Renzy Alarcon
+// Licensed under the MIT License (MIT).
+//
+//*********************************************************
+
+#pragma once
+#include "span_tuple.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace xk
+{
+    /// <summary>
+    /// An owning structure of arrays container. Every column lives in one allocation and all columns grow together,
+    /// so element i of every column is always valid at the same time. Views of it are span_tuples
+    /// </summary>
+    template<class First, class... Ty>
+    class soa_vector
+    {
+    public:
+        using value_type = std::tuple<First, Ty...>;
+        using pointer = std::tuple<First*, Ty*...>;
+        using const_pointer = std::tuple<const First*, const Ty*...>;
+        using reference = std::tuple<First&, Ty&...>;
+        using const_reference = std::tuple<const First&, const Ty&...>;
+        using size_type = size_t;
+        using difference_type = ptrdiff_t;
+        using iterator = span_tuple_iterator<First, Ty...>;
+        using const_iterator = span_tuple_iterator<const First, const Ty...>;
+        using reverse_iterator = ::std::reverse_iterator<iterator>;
+        using const_reverse_iterator = ::std::reverse_iterator<const_iterator>;
+        using view_type = dynamic_extent_span_tuple<First, Ty...>;
+        using const_view_type = dynamic_extent_span_tuple<const First, const Ty...>;
+
+        template<size_t Index>
+        using column_type = std::tuple_element_t<Index, value_type>;
+
+        static constexpr size_type column_count = sizeof...(Ty) + 1;
+
+        //Every column starts on its own cache line, which also keeps them aligned for SIMD loads
+        static constexpr size_type column_alignment = std::max({ size_type(64), alignof(First), alignof(Ty)... });
+
+    private:
+        using column_indices = std::make_index_sequence<column_count>;
+
+        std::byte* m_block = nullptr;
+        pointer m_columns = {};
+        size_type m_size = 0;
+        size_type m_capacity = 0;
+
+    public:
+        constexpr soa_vector() noexcept = default;
+
+        //The destructor doesn't run when a constructor throws, so the constructors release the block themselves
+        explicit soa_vector(size_type count)
+        {
+            try
+            {
+                resize(count);
+            }
+            catch(...)
+            {
+                deallocate(m_block);
+                throw;
+            }
+        }
+
+        soa_vector(const soa_vector& other)
+        {
+            try
+            {
+                reserve(other.m_size);
+                construct_back(other.m_size, [&](auto index, auto* column)
+                {
+                    std::uninitialized_copy_n(std::get<decltype(index)::value>(other.m_columns), other.m_size, column);
+                });
+            }
+            catch(...)
+            {
+                deallocate(m_block);
+                throw;
+            }
+        }
+
+        soa_vector(soa_vector&& other) noexcept :
+            m_block{ std::exchange(other.m_block, nullptr) },
+            m_columns{ std::exchange(other.m_columns, pointer{}) },
+            m_size{ std::exchange(other.m_size, 0) },
+            m_capacity{ std::exchange(other.m_capacity, 0) }
+        {
+        }
+
+        ~soa_vector()
+        {
+            clear();
+            deallocate(m_block);
+        }
+
+        soa_vector& operator=(soa_vector other) noexcept
+        {
+            swap(other);
+            return *this;
+        }
+
+    public:
+        //Gets a non-owning view of every column
+        XK_SPAN_TUPLE_NODISCARD view_type view() noexcept { return make_view<view_type>(column_indices{}); }
+        XK_SPAN_TUPLE_NODISCARD const_view_type view() const noexcept { return make_view<const_view_type>(column_indices{}); }
+
+        operator view_type() noexcept { return view(); }
+        operator const_view_type() const noexcept { return view(); }
+
+        //Gets a single column
+        template<size_t Index>
+        XK_SPAN_TUPLE_NODISCARD std::span<column_type<Index>> column() noexcept { return { std::get<Index>(m_columns), m_size }; }
+
+        template<size_t Index>
+        XK_SPAN_TUPLE_NODISCARD std::span<const column_type<Index>> column() const noexcept { return { std::get<Index>(m_columns), m_size }; }
+
+        //Gets pointers to the beginning of all columns
+        XK_SPAN_TUPLE_NODISCARD pointer data() noexcept { return m_columns; }
+        XK_SPAN_TUPLE_NODISCARD const_pointer data() const noexcept { return m_columns; }
+
+        template<size_t Index>
+        XK_SPAN_TUPLE_NODISCARD column_type<Index>* data() noexcept { return std::get<Index>(m_columns); }
+
+        template<size_t Index>
+        XK_SPAN_TUPLE_NODISCARD const column_type<Index>* data() const noexcept { return std::get<Index>(m_columns); }
+
+        //Gets all the elements of a given offset
+        XK_SPAN_TUPLE_NODISCARD reference operator[](size_type offset) noexcept
+        {
+            assert(offset < m_size && "soa_vector index out of range");
+            return begin()[offset];
+        }
+
+        XK_SPAN_TUPLE_NODISCARD const_reference operator[](size_type offset) const noexcept
+        {
+            assert(offset < m_size && "soa_vector index out of range");
+            return begin()[offset];
+        }
+
+        XK_SPAN_TUPLE_NODISCARD reference front() noexcept { return (*this)[0]; }
+        XK_SPAN_TUPLE_NODISCARD const_reference front() const noexcept { return (*this)[0]; }
+        XK_SPAN_TUPLE_NODISCARD reference back() noexcept { return (*this)[m_size - 1]; }
+        XK_SPAN_TUPLE_NODISCARD const_reference back() const noexcept { return (*this)[m_size - 1]; }
+
+        XK_SPAN_TUPLE_NODISCARD iterator begin() noexcept { return { m_columns }; }
+        XK_SPAN_TUPLE_NODISCARD const_iterator begin() const noexcept { return { m_columns }; }
+        XK_SPAN_TUPLE_NODISCARD const_iterator cbegin() const noexcept { return begin(); }
+        XK_SPAN_TUPLE_NODISCARD iterator end() noexcept { return begin() + static_cast<difference_type>(m_size); }
+        XK_SPAN_TUPLE_NODISCARD const_iterator end() const noexcept { return begin() + static_cast<difference_type>(m_size); }
+        XK_SPAN_TUPLE_NODISCARD const_iterator cend() const noexcept { return end(); }
+        XK_SPAN_TUPLE_NODISCARD reverse_iterator rbegin() noexcept { return reverse_iterator{ end() }; }
+        XK_SPAN_TUPLE_NODISCARD const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{ end() }; }
+        XK_SPAN_TUPLE_NODISCARD reverse_iterator rend() noexcept { return reverse_iterator{ begin() }; }
+        XK_SPAN_TUPLE_NODISCARD const_reverse_iterator rend() const noexcept { return const_reverse_iterator{ begin() }; }
+
+        XK_SPAN_TUPLE_NODISCARD size_type size() const noexcept { return m_size; }
+        XK_SPAN_TUPLE_NODISCARD size_type capacity() const noexcept { return m_capacity; }
+        XK_SPAN_TUPLE_NODISCARD bool empty() const noexcept { return m_size == 0; }
+
+    public:
+        //Appends one element to every column, taking one argument per column.
+        //Like the columns' own spans, arguments referring into this vector are invalidated if it grows
+        template<class FirstArg, class... Args>
+            requires (sizeof...(Args) == sizeof...(Ty))
+        reference emplace_back(FirstArg&& firstArg, Args&&... args)
+        {
+            grow_to(m_size + 1);
+            auto arguments = std::forward_as_tuple(std::forward<FirstArg>(firstArg), std::forward<Args>(args)...);
+            construct_back(1, [&](auto index, auto* column)
+            {
+                std::construct_at(column, std::get<decltype(index)::value>(std::move(arguments)));
+            });
+            return back();
+        }
+
+        void push_back(const First& first, const Ty&... others)
+        {
+            emplace_back(first, others...);
+        }
+
+        void push_back(First&& first, Ty&&... others)
+        {
+            emplace_back(std::move(first), std::move(others)...);
+        }
+
+        void pop_back() noexcept
+        {
+            assert(m_size > 0 && "pop_back on empty soa_vector");
+            destroy_back(m_size - 1);
+        }
+
+        /// <summary>
+        /// Removes the element at offset by moving the last element into its place. Does not preserve order
+        /// </summary>
+        void swap_remove(size_type offset) noexcept(std::is_nothrow_move_assignable_v<First> && (std::is_nothrow_move_assignable_v<Ty> && ...))
+        {
+            assert(offset < m_size && "soa_vector index out of range");
+            if(offset != m_size - 1)
+            {
+                std::apply([&](auto*... columns)
+                {
+                    ((columns[offset] = std::move(columns[m_size - 1])), ...);
+                }, m_columns);
+            }
+            pop_back();
+        }
+
+        void resize(size_type count)
+        {
+            if(count <= m_size)
+            {
+                destroy_back(count);
+                return;
+            }
+
+            reserve(count);
+            construct_back(count - m_size, [&](auto, auto* column)
+            {
+                std::uninitialized_value_construct_n(column, count - m_size);
+            });
+        }
+
+        void reserve(size_type count)
+        {
+            if(count > m_capacity)
+                reallocate(count);
+        }
+
+        void shrink_to_fit()
+        {
+            if(m_size == 0)
+            {
+                deallocate(std::exchange(m_block, nullptr));
+                m_columns = {};
+                m_capacity = 0;
+            }
+            else if(m_size != m_capacity)
+            {
+                reallocate(m_size);
+            }
+        }
+
+        void clear() noexcept
+        {
+            destroy_back(0);
+        }
+
+        void swap(soa_vector& other) noexcept
+        {
+            std::swap(m_block, other.m_block);
+            std::swap(m_columns, other.m_columns);
+            std::swap(m_size, other.m_size);
+            std::swap(m_capacity, other.m_capacity);
+        }
+
+        friend void swap(soa_vector& left, soa_vector& right) noexcept
+        {
+            left.swap(right);
+        }
+
+    private:
+        template<class ViewTy, size_t... Indices>
+        ViewTy make_view(std::index_sequence<0, Indices...>) const noexcept
+        {
+            return ViewTy{ std::get<0>(m_columns), m_size, std::get<Indices>(m_columns)... };
+        }
+
+        static constexpr size_type column_size(size_type elementSize, size_type count) noexcept
+        {
+            return (elementSize * count + column_alignment - 1) / column_alignment * column_alignment;
+        }
+
+        static std::byte* allocate(size_type capacity)
+        {
+            const size_type bytes = (column_size(sizeof(First), capacity) + ... + column_size(sizeof(Ty), capacity));
+            return static_cast<std::byte*>(::operator new(bytes, std::align_val_t{ column_alignment }));
+        }
+
+        static void deallocate(std::byte* block) noexcept
+        {
+            if(block)
+                ::operator delete(block, std::align_val_t{ column_alignment });
+        }
+
+        //Columns are laid out back to back, each padded to the column alignment
+        template<size_t... Indices>
+        static pointer layout(std::byte* block, size_type capacity, std::index_sequence<Indices...>) noexcept
+        {
+            pointer columns;
+            size_type offset = 0;
+            ((std::get<Indices>(columns) = reinterpret_cast<column_type<Indices>*>(block + offset),
+                offset += column_size(sizeof(column_type<Indices>), capacity)), ...);
+            return columns;
+        }
+
+        void grow_to(size_type count)
+        {
+            if(count > m_capacity)
+                reallocate(std::max(count, m_capacity * 2));
+        }
+
+        void reallocate(size_type capacity)
+        {
+            assert(capacity >= m_size);
+            std::byte* block = allocate(capacity);
+            const pointer columns = layout(block, capacity, column_indices{});
+
+            [&]<size_t... Indices>(std::index_sequence<Indices...>)
+            {
+                size_type relocated = 0;
+                try
+                {
+                    ((relocate(std::get<Indices>(m_columns), m_size, std::get<Indices>(columns)), relocated++), ...);
+                }
+                catch(...)
+                {
+                    ((Indices < relocated ? (void)std::destroy_n(std::get<Indices>(columns), m_size) : void()), ...);
+                    deallocate(block);
+                    throw;
+                }
+            }(column_indices{});
+
+            const size_type size = m_size;
+            clear();
+            deallocate(m_block);
+            m_block = block;
+            m_columns = columns;
+            m_size = size;
+            m_capacity = capacity;
+        }
+
+        template<class ElementTy>
+        static void relocate(ElementTy* from, size_type count, ElementTy* to)
+        {
+            if constexpr(std::is_nothrow_move_constructible_v<ElementTy> || !std::is_copy_constructible_v<ElementTy>)
+                std::uninitialized_move_n(from, count, to);
+            else
+                std::uninitialized_copy_n(from, count, to);
+        }
+
+        //Constructs count elements past the end of every column with construct(index, column), then grows the size.
+        //If a column throws, the columns already constructed are destroyed again
+        template<class ConstructFn>
+        void construct_back(size_type count, ConstructFn&& construct)
+        {
+            assert(m_size + count <= m_capacity);
+            [&]<size_t... Indices>(std::index_sequence<Indices...>)
+            {
+                size_type constructed = 0;
+                try
+                {
+                    ((construct(std::integral_constant<size_t, Indices>{}, std::get<Indices>(m_columns) + m_size), constructed++), ...);
+                }
+                catch(...)
+                {
+                    ((Indices < constructed ? (void)std::destroy_n(std::get<Indices>(m_columns) + m_size, count) : void()), ...);
+                    throw;
+                }
+            }(column_indices{});
+            m_size += count;
+        }
+
+        void destroy_back(size_type count) noexcept
+        {
+            std::apply([&](auto*... columns)
+            {
+                (std::destroy(columns + count, columns + m_size), ...);
+            }, m_columns);
+            m_size = count;
+        }
+    };
+}
@@ -0,0 +1,21 @@
+module;
+
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <type_traits>
+
+export module TypedD3D.Shared:Alignment;
+
+namespace TypedD3D
+{
+	/// <summary>
+	/// Rounds value up to the next multiple of alignment, which must be a power of two
+	/// </summary>
+	export template<std::unsigned_integral Ty>
+	constexpr Ty AlignUp(Ty value, std::type_identity_t<Ty> alignment) noexcept
+	{
+		assert(std::has_single_bit(alignment));
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
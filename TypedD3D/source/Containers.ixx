@@ -5,10 +5,12 @@ module;
 #include <utility>
 #include <algorithm>
 #include <array>
+#include <source_location>
 #include <span>
 #include <vector>
 
 export module TypedD3D.Shared:Containers;
+import :Instrumentation;
 
 namespace TypedD3D
 {
@@ -161,7 +163,12 @@ namespace TypedD3D
 	struct InterfaceBase
 	{
 		InterfaceProxy<TraitTy>& ToDerived() { return static_cast<InterfaceProxy<TraitTy>&>(*this); }
+#ifdef TYPEDD3D_INSTRUMENTATION
+		//The scope is bound to a reference parameter so it lives until the end of the full expression, which covers the call made through the returned reference
+		GetTraitInnerType<TraitTy> & Self(const Instrumentation::CallScope& = Instrumentation::CallScope(std::source_location::current())) { return *ToDerived().InterfaceProxy<TraitTy>::Get(); }
+#else
 		GetTraitInnerType<TraitTy> & Self() { return *ToDerived().InterfaceProxy<TraitTy>::Get(); }
+#endif
 	};
 
 	export template<IUnknownTrait TraitTy>
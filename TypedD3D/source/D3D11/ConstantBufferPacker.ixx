@@ -0,0 +1,121 @@
+module;
+
+#include <d3d11_4.h>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+export module TypedD3D11:ConstantBufferPacker;
+import TypedD3D.Shared;
+import :Device;
+import :DeviceContext;
+import :DynamicBufferRing;
+
+namespace TypedD3D::D3D11
+{
+	//*SetConstantBuffers1 ranges start on multiples of 16 constants and span multiples of 16 constants
+	constexpr UINT constantRangeAlignment = 256;
+
+	export struct PackedConstants
+	{
+		//Offset of the constants within the frame's packed data, in bytes
+		UINT offset = 0;
+		UINT size = 0;
+	};
+
+	export struct ConstantBufferRange
+	{
+		UINT firstConstant = 0;
+		UINT numConstants = 0;
+	};
+
+	/// <summary>
+	/// Lays out every draw's constants for a frame into one CPU side block, then uploads the whole block with a single map of a large constant buffer.
+	/// Draws bind their range of that buffer through the *SetConstantBuffers1 functions instead of mapping a small constant buffer each.
+	/// Pack constants, call Upload once, then bind each draw with GetRange.
+	/// Throws if the device doesn't support constant buffer offsetting, which needs Windows 8 and a WDDM 1.2 driver
+	/// </summary>
+	export class ConstantBufferPacker
+	{
+		DynamicBufferRing ring;
+		std::vector<std::byte> packed;
+		UINT uploadedOffset = 0;
+		bool uploaded = false;
+
+	public:
+		ConstantBufferPacker(Wrapper<ID3D11Device> device, UINT sizeInBytes = 4 * 1024 * 1024) :
+			ring{ RequireConstantBufferOffsetting(std::move(device)), sizeInBytes, D3D11_BIND_CONSTANT_BUFFER }
+		{
+		}
+
+	public:
+		PackedConstants Pack(const void* data, UINT size)
+		{
+			assert(!uploaded);
+			if(size == 0 || size > D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT * 16)
+				throw std::invalid_argument("Constant buffer ranges hold between 1 and 4096 constants");
+
+			const PackedConstants constants{ static_cast<UINT>(packed.size()), size };
+			packed.resize(packed.size() + (size + constantRangeAlignment - 1) / constantRangeAlignment * constantRangeAlignment);
+			std::memcpy(packed.data() + constants.offset, data, size);
+			return constants;
+		}
+
+		template<class Ty>
+			requires std::is_trivially_copyable_v<Ty>
+		PackedConstants Pack(const Ty& constants)
+		{
+			return Pack(&constants, sizeof(Ty));
+		}
+
+		/// <summary>
+		/// Copies everything packed this frame into the constant buffer with one map on the immediate context
+		/// </summary>
+		template<class ContextTy>
+		void Upload(ContextTy& context)
+		{
+			assert(!uploaded);
+			uploaded = true;
+			if(packed.empty())
+				return;
+
+			uploadedOffset = ring.Write(context, std::span<const std::byte>(packed), constantRangeAlignment).offset;
+		}
+
+		/// <summary>
+		/// The range of the constant buffer holding constants, only valid after Upload
+		/// </summary>
+		ConstantBufferRange GetRange(PackedConstants constants) const noexcept
+		{
+			assert(uploaded);
+			return { (uploadedOffset + constants.offset) / 16, (constants.size + constantRangeAlignment - 1) / constantRangeAlignment * 16 };
+		}
+
+		/// <summary>
+		/// Starts packing the next frame, ranges from the previous frame become invalid
+		/// </summary>
+		void Reset() noexcept
+		{
+			packed.clear();
+			uploaded = false;
+		}
+
+	public:
+		Wrapper<ID3D11Buffer>& GetBuffer() noexcept { return ring.GetBuffer(); }
+		size_t GetPackedSize() const noexcept { return packed.size(); }
+		const DynamicBufferRing& GetRing() const noexcept { return ring; }
+
+	private:
+		static Wrapper<ID3D11Device> RequireConstantBufferOffsetting(Wrapper<ID3D11Device> device)
+		{
+			if(!device->CheckFeatureSupport<D3D11_FEATURE_D3D11_OPTIONS>().ConstantBufferOffsetting)
+				throw std::invalid_argument("The device doesn't support constant buffer offsetting");
+			return device;
+		}
+	};
+}
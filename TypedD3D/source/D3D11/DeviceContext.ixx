@@ -1496,4 +1496,147 @@ namespace TypedD3D
 			using InterfaceBase<Untagged<Derived>>::ToDerived;
 		};
 	};
-}
\ No newline at end of file
+
+	template<>
+	struct Trait<Untagged<ID3D11DeviceContext1>>
+	{
+		using inner_type = ID3D11DeviceContext1;
+
+		using inner_tag = ID3D11DeviceContext1;
+
+		template<class NewInner>
+		using ReplaceInnerType = Untagged<NewInner>;
+
+		template<class NewInner>
+		using trait_template = Untagged<NewInner>;
+
+		template<class Derived>
+		struct Interface : TraitInterface<Untagged<ID3D11DeviceContext>, Derived>
+		{
+			//FirstConstant and NumConstants are in 16 byte constants, FirstConstant must be a multiple of 16 and NumConstants a multiple of 16 up to 4096
+			void VSSetConstantBuffers1(
+				UINT StartSlot,
+				Span<const WrapperView<ID3D11Buffer>> ppConstantBuffers,
+				std::span<const UINT> pFirstConstant,
+				std::span<const UINT> pNumConstants)
+			{
+				assert(ppConstantBuffers.size() == pFirstConstant.size() && ppConstantBuffers.size() == pNumConstants.size());
+				Self().VSSetConstantBuffers1(StartSlot, static_cast<UINT>(ppConstantBuffers.size()), ppConstantBuffers.data(), pFirstConstant.data(), pNumConstants.data());
+			}
+
+			void VSSetConstantBuffers1(
+				UINT StartSlot,
+				WrapperView<ID3D11Buffer> pConstantBuffer,
+				UINT FirstConstant,
+				UINT NumConstants)
+			{
+				auto temp = pConstantBuffer.Get();
+				VSSetConstantBuffers1(StartSlot, Span<const WrapperView<ID3D11Buffer>>{ &temp, 1 }, std::span{ &FirstConstant, 1 }, std::span{ &NumConstants, 1 });
+			}
+
+			void HSSetConstantBuffers1(
+				UINT StartSlot,
+				Span<const WrapperView<ID3D11Buffer>> ppConstantBuffers,
+				std::span<const UINT> pFirstConstant,
+				std::span<const UINT> pNumConstants)
+			{
+				assert(ppConstantBuffers.size() == pFirstConstant.size() && ppConstantBuffers.size() == pNumConstants.size());
+				Self().HSSetConstantBuffers1(StartSlot, static_cast<UINT>(ppConstantBuffers.size()), ppConstantBuffers.data(), pFirstConstant.data(), pNumConstants.data());
+			}
+
+			void HSSetConstantBuffers1(
+				UINT StartSlot,
+				WrapperView<ID3D11Buffer> pConstantBuffer,
+				UINT FirstConstant,
+				UINT NumConstants)
+			{
+				auto temp = pConstantBuffer.Get();
+				HSSetConstantBuffers1(StartSlot, Span<const WrapperView<ID3D11Buffer>>{ &temp, 1 }, std::span{ &FirstConstant, 1 }, std::span{ &NumConstants, 1 });
+			}
+
+			void DSSetConstantBuffers1(
+				UINT StartSlot,
+				Span<const WrapperView<ID3D11Buffer>> ppConstantBuffers,
+				std::span<const UINT> pFirstConstant,
+				std::span<const UINT> pNumConstants)
+			{
+				assert(ppConstantBuffers.size() == pFirstConstant.size() && ppConstantBuffers.size() == pNumConstants.size());
+				Self().DSSetConstantBuffers1(StartSlot, static_cast<UINT>(ppConstantBuffers.size()), ppConstantBuffers.data(), pFirstConstant.data(), pNumConstants.data());
+			}
+
+			void DSSetConstantBuffers1(
+				UINT StartSlot,
+				WrapperView<ID3D11Buffer> pConstantBuffer,
+				UINT FirstConstant,
+				UINT NumConstants)
+			{
+				auto temp = pConstantBuffer.Get();
+				DSSetConstantBuffers1(StartSlot, Span<const WrapperView<ID3D11Buffer>>{ &temp, 1 }, std::span{ &FirstConstant, 1 }, std::span{ &NumConstants, 1 });
+			}
+
+			void GSSetConstantBuffers1(
+				UINT StartSlot,
+				Span<const WrapperView<ID3D11Buffer>> ppConstantBuffers,
+				std::span<const UINT> pFirstConstant,
+				std::span<const UINT> pNumConstants)
+			{
+				assert(ppConstantBuffers.size() == pFirstConstant.size() && ppConstantBuffers.size() == pNumConstants.size());
+				Self().GSSetConstantBuffers1(StartSlot, static_cast<UINT>(ppConstantBuffers.size()), ppConstantBuffers.data(), pFirstConstant.data(), pNumConstants.data());
+			}
+
+			void GSSetConstantBuffers1(
+				UINT StartSlot,
+				WrapperView<ID3D11Buffer> pConstantBuffer,
+				UINT FirstConstant,
+				UINT NumConstants)
+			{
+				auto temp = pConstantBuffer.Get();
+				GSSetConstantBuffers1(StartSlot, Span<const WrapperView<ID3D11Buffer>>{ &temp, 1 }, std::span{ &FirstConstant, 1 }, std::span{ &NumConstants, 1 });
+			}
+
+			void PSSetConstantBuffers1(
+				UINT StartSlot,
+				Span<const WrapperView<ID3D11Buffer>> ppConstantBuffers,
+				std::span<const UINT> pFirstConstant,
+				std::span<const UINT> pNumConstants)
+			{
+				assert(ppConstantBuffers.size() == pFirstConstant.size() && ppConstantBuffers.size() == pNumConstants.size());
+				Self().PSSetConstantBuffers1(StartSlot, static_cast<UINT>(ppConstantBuffers.size()), ppConstantBuffers.data(), pFirstConstant.data(), pNumConstants.data());
+			}
+
+			void PSSetConstantBuffers1(
+				UINT StartSlot,
+				WrapperView<ID3D11Buffer> pConstantBuffer,
+				UINT FirstConstant,
+				UINT NumConstants)
+			{
+				auto temp = pConstantBuffer.Get();
+				PSSetConstantBuffers1(StartSlot, Span<const WrapperView<ID3D11Buffer>>{ &temp, 1 }, std::span{ &FirstConstant, 1 }, std::span{ &NumConstants, 1 });
+			}
+
+			void CSSetConstantBuffers1(
+				UINT StartSlot,
+				Span<const WrapperView<ID3D11Buffer>> ppConstantBuffers,
+				std::span<const UINT> pFirstConstant,
+				std::span<const UINT> pNumConstants)
+			{
+				assert(ppConstantBuffers.size() == pFirstConstant.size() && ppConstantBuffers.size() == pNumConstants.size());
+				Self().CSSetConstantBuffers1(StartSlot, static_cast<UINT>(ppConstantBuffers.size()), ppConstantBuffers.data(), pFirstConstant.data(), pNumConstants.data());
+			}
+
+			void CSSetConstantBuffers1(
+				UINT StartSlot,
+				WrapperView<ID3D11Buffer> pConstantBuffer,
+				UINT FirstConstant,
+				UINT NumConstants)
+			{
+				auto temp = pConstantBuffer.Get();
+				CSSetConstantBuffers1(StartSlot, Span<const WrapperView<ID3D11Buffer>>{ &temp, 1 }, std::span{ &FirstConstant, 1 }, std::span{ &NumConstants, 1 });
+			}
+
+		private:
+			using InterfaceBase<Untagged<Derived>>::Self;
+			using InterfaceBase<Untagged<Derived>>::ToDerived;
+		};
+	};
+}
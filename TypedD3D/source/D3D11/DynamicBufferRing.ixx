@@ -0,0 +1,148 @@
+module;
+
+#include <d3d11_4.h>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+export module TypedD3D11:DynamicBufferRing;
+import TypedD3D.Shared;
+import :Device;
+import :DeviceContext;
+import :Resources;
+
+namespace TypedD3D::D3D11
+{
+	export struct DynamicAllocation
+	{
+		std::byte* cpuAddress = nullptr;
+
+		//Offset in bytes, for IASetVertexBuffers offsets and IASetIndexBuffer
+		UINT offset = 0;
+		UINT size = 0;
+
+		//The range in 16 byte constants, for the *SetConstantBuffers1 functions
+		UINT FirstConstant() const noexcept { return offset / 16; }
+		UINT NumConstants() const noexcept { return (size + 255) / 256 * 16; }
+	};
+
+	export struct DynamicBufferRingStatistics
+	{
+		UINT64 allocations = 0;
+		UINT64 discards = 0;
+		UINT64 bytesAllocated = 0;
+	};
+
+	/// <summary>
+	/// Sub-allocates dynamic vertex, index or constant data from one large dynamic buffer.
+	/// Allocations are appended with D3D11_MAP_WRITE_NO_OVERWRITE and the buffer is only discarded when the ring wraps,
+	/// so the driver renames the buffer once per wrap rather than once per upload.
+	/// Constant buffer rings align allocations to 256 bytes so they can be bound with the *SetConstantBuffers1 functions.
+	/// If the driver can't map constant buffers with NO_OVERWRITE every map discards instead.
+	/// Only map the ring on the immediate context: deferred contexts must discard before their first NO_OVERWRITE map,
+	/// and the ring only knows whether the immediate context has discarded
+	/// </summary>
+	export class DynamicBufferRing
+	{
+		Wrapper<ID3D11Buffer> buffer;
+		UINT capacity;
+		UINT head = 0;
+		UINT minimumAlignment;
+		bool discardNextMap = true;
+		bool discardEveryMap = false;
+		bool mapped = false;
+		DynamicBufferRingStatistics statistics;
+
+	public:
+		DynamicBufferRing(Wrapper<ID3D11Device> device, UINT sizeInBytes, UINT bindFlags = D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_INDEX_BUFFER) :
+			capacity{ sizeInBytes },
+			minimumAlignment{ (bindFlags & D3D11_BIND_CONSTANT_BUFFER) ? 256u : 16u }
+		{
+			if(sizeInBytes == 0 || sizeInBytes % minimumAlignment != 0)
+				throw std::invalid_argument("The ring size must be a non zero multiple of the allocation alignment");
+
+			if(bindFlags & D3D11_BIND_CONSTANT_BUFFER)
+				discardEveryMap = !device->CheckFeatureSupport<D3D11_FEATURE_D3D11_OPTIONS>().MapNoOverwriteOnDynamicConstantBuffer;
+
+			D3D11_BUFFER_DESC desc
+			{
+				.ByteWidth = sizeInBytes,
+				.Usage = D3D11_USAGE_DYNAMIC,
+				.BindFlags = bindFlags,
+				.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE
+			};
+			buffer = device->CreateBuffer(desc);
+		}
+
+		DynamicBufferRing(const DynamicBufferRing&) = delete;
+		DynamicBufferRing& operator=(const DynamicBufferRing&) = delete;
+
+	public:
+		/// <summary>
+		/// Maps size bytes of the ring for writing. The buffer stays mapped until Unmap is called, which must happen before the draw using it
+		/// </summary>
+		template<class ContextTy>
+		DynamicAllocation Map(ContextTy& context, UINT size, UINT alignment = 16)
+		{
+			assert(!mapped);
+			assert(context->GetType() == D3D11_DEVICE_CONTEXT_IMMEDIATE && "Dynamic buffer rings can only be mapped on the immediate context");
+			alignment = std::max(alignment, minimumAlignment);
+			const UINT allocationSize = AlignUp(size, minimumAlignment);
+			if(allocationSize > capacity)
+				throw std::invalid_argument("Allocation is larger than the ring");
+
+			UINT offset = AlignUp(head, alignment);
+			D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+			if(discardNextMap || discardEveryMap || offset + allocationSize > capacity)
+			{
+				mapType = D3D11_MAP_WRITE_DISCARD;
+				offset = 0;
+				discardNextMap = false;
+				statistics.discards++;
+			}
+
+			D3D11_MAPPED_SUBRESOURCE subresource = context->Map(buffer, 0, mapType, 0);
+			mapped = true;
+			head = offset + allocationSize;
+
+			statistics.allocations++;
+			statistics.bytesAllocated += allocationSize;
+			return { static_cast<std::byte*>(subresource.pData) + offset, offset, size };
+		}
+
+		template<class ContextTy>
+		void Unmap(ContextTy& context)
+		{
+			assert(mapped);
+			context->Unmap(buffer, 0);
+			mapped = false;
+		}
+
+		/// <summary>
+		/// Copies data into the ring and unmaps it
+		/// </summary>
+		template<class ContextTy, class Ty>
+		DynamicAllocation Write(ContextTy& context, std::span<const Ty> data, UINT alignment = 16)
+		{
+			DynamicAllocation allocation = Map(context, static_cast<UINT>(data.size_bytes()), alignment);
+			std::memcpy(allocation.cpuAddress, data.data(), data.size_bytes());
+			Unmap(context);
+			return allocation;
+		}
+
+	public:
+		Wrapper<ID3D11Buffer>& GetBuffer() noexcept { return buffer; }
+		UINT GetCapacity() const noexcept { return capacity; }
+		bool DiscardsEveryMap() const noexcept { return discardEveryMap; }
+		const DynamicBufferRingStatistics& GetStatistics() const noexcept { return statistics; }
+
+	private:
+		static constexpr UINT AlignUp(UINT value, UINT alignment) noexcept
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+	};
+}
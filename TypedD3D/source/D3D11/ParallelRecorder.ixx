@@ -0,0 +1,157 @@
+module;
+
+#include <d3d11_4.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
+export module TypedD3D11:ParallelRecorder;
+import TypedD3D.Shared;
+import :Device;
+import :DeviceContext;
+
+namespace TypedD3D::D3D11
+{
+	/// <summary>
+	/// Records jobs in parallel on a pool of deferred contexts and executes the resulting command lists on the immediate context in the order the jobs were added.
+	/// When the driver doesn't support command lists natively the runtime emulates them, which costs more than it saves, so the jobs are recorded serially on the immediate context instead.
+	/// Every job starts from the default pipeline state in both modes and the immediate context is left in the default state.
+	/// The device must not be created with D3D11_CREATE_DEVICE_SINGLETHREADED
+	/// </summary>
+	export class ParallelRecorder
+	{
+	public:
+		using Job = std::function<void(Wrapper<ID3D11DeviceContext>& context)>;
+
+	private:
+		Wrapper<ID3D11DeviceContext> immediateContext;
+		std::vector<Wrapper<ID3D11DeviceContext>> deferredContexts;
+		D3D11_FEATURE_DATA_THREADING threadingSupport{};
+		ParallelFor parallelFor;
+
+		std::vector<Job> jobs;
+		std::vector<Wrapper<ID3D11CommandList>> commandLists;
+
+	public:
+		ParallelRecorder(
+			Wrapper<ID3D11Device> device,
+			Wrapper<ID3D11DeviceContext> immediateContext,
+			UINT maxDeferredContexts = std::max(std::thread::hardware_concurrency(), 1u),
+			ParallelFor parallelFor = nullptr) :
+			immediateContext{ std::move(immediateContext) },
+			threadingSupport{ device->CheckFeatureSupport<D3D11_FEATURE_THREADING>() },
+			parallelFor{ parallelFor ? std::move(parallelFor) : ParallelFor{ &RunOnThreads } }
+		{
+			assert(this->immediateContext->GetType() == D3D11_DEVICE_CONTEXT_IMMEDIATE);
+			if(!threadingSupport.DriverCommandLists || maxDeferredContexts < 2)
+				return;
+
+			deferredContexts.reserve(maxDeferredContexts);
+			for(UINT i = 0; i < maxDeferredContexts; i++)
+				deferredContexts.push_back(device->CreateDeferredContext(0));
+		}
+
+		ParallelRecorder(const ParallelRecorder&) = delete;
+		ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+	public:
+		/// <summary>
+		/// Queues a job to be recorded by the next Execute. Returns the job's position in submission order
+		/// </summary>
+		size_t AddJob(Job job)
+		{
+			jobs.push_back(std::move(job));
+			return jobs.size() - 1;
+		}
+
+		/// <summary>
+		/// Records every queued job and executes them on the immediate context in the order they were added.
+		/// If a job throws, nothing is executed and the first exception is rethrown once every worker stopped.
+		/// When recording serially the jobs run directly on the immediate context, so the jobs before the one that threw have already been executed.
+		/// The immediate context is left in the default state either way
+		/// </summary>
+		void Execute()
+		{
+			std::vector<Job> pending = std::move(jobs);
+			jobs.clear();
+			if(pending.empty())
+				return;
+
+			if(!IsParallel())
+			{
+				try
+				{
+					for(Job& job : pending)
+					{
+						job(immediateContext);
+						immediateContext->ClearState();
+					}
+				}
+				catch(...)
+				{
+					immediateContext->ClearState();
+					throw;
+				}
+				return;
+			}
+
+			commandLists.clear();
+			commandLists.resize(pending.size());
+
+			const size_t workerCount = std::min(deferredContexts.size(), pending.size());
+			std::atomic<size_t> nextJob = 0;
+			std::vector<std::exception_ptr> errors(workerCount);
+
+			parallelFor(workerCount, [&](size_t worker)
+			{
+				Wrapper<ID3D11DeviceContext>& context = deferredContexts[worker];
+				try
+				{
+					for(size_t job = nextJob++; job < pending.size(); job = nextJob++)
+					{
+						pending[job](context);
+						commandLists[job] = context->FinishCommandList(false);
+					}
+				}
+				catch(...)
+				{
+					errors[worker] = std::current_exception();
+
+					//Stops the other workers from taking new jobs and drops anything half recorded
+					nextJob = pending.size();
+					try
+					{
+						context->FinishCommandList(false);
+					}
+					catch(...)
+					{
+					}
+				}
+			});
+
+			for(std::exception_ptr& error : errors)
+			{
+				if(error)
+				{
+					commandLists.clear();
+					std::rethrow_exception(error);
+				}
+			}
+
+			for(Wrapper<ID3D11CommandList>& commandList : commandLists)
+				immediateContext->ExecuteCommandList(commandList, false);
+
+			commandLists.clear();
+		}
+
+	public:
+		bool IsParallel() const noexcept { return !deferredContexts.empty(); }
+		const D3D11_FEATURE_DATA_THREADING& GetThreadingSupport() const noexcept { return threadingSupport; }
+		size_t GetDeferredContextCount() const noexcept { return deferredContexts.size(); }
+		size_t GetPendingJobCount() const noexcept { return jobs.size(); }
+	};
+}
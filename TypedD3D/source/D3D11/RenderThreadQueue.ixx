@@ -0,0 +1,311 @@
+module;
+
+#include <d3d11_4.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+export module TypedD3D11:RenderThreadQueue;
+import TypedD3D.Shared;
+import :DeviceContext;
+
+namespace TypedD3D::D3D11
+{
+	export class RenderThreadQueue;
+
+	/// <summary>
+	/// A sequence of device context calls recorded as callables packed into fixed size chunks, which never move once constructed
+	/// </summary>
+	export class CommandBatch
+	{
+		static constexpr size_t chunkSize = 64 * 1024;
+		static constexpr size_t commandAlignment = alignof(std::max_align_t);
+
+		struct CommandHeader
+		{
+			//Runs the command and destroys it, or only destroys it when context is null. The command is destroyed even if running it throws
+			void (*execute)(void* command, Wrapper<ID3D11DeviceContext>* context);
+			CommandHeader* next;
+		};
+
+		struct Chunk
+		{
+			std::unique_ptr<std::byte[]> memory;
+			size_t size;
+			size_t used = 0;
+		};
+
+		std::vector<Chunk> chunks;
+		size_t currentChunk = 0;
+		CommandHeader* first = nullptr;
+		CommandHeader* last = nullptr;
+		size_t commandCount = 0;
+
+		//Links the batch into the render thread's queue, then into its recorder's list of batches to reuse
+		friend class RenderThreadQueue;
+		CommandBatch* next = nullptr;
+		std::shared_ptr<void> returnList;
+
+	public:
+		CommandBatch() = default;
+		CommandBatch(const CommandBatch&) = delete;
+		CommandBatch& operator=(const CommandBatch&) = delete;
+		~CommandBatch() { Destroy(nullptr); }
+
+	public:
+		/// <summary>
+		/// Records command, which is called with the immediate context on the render thread
+		/// </summary>
+		template<class Fn>
+			requires std::invocable<std::decay_t<Fn>&, Wrapper<ID3D11DeviceContext>&>
+		void Enqueue(Fn&& command)
+		{
+			using Command = std::decay_t<Fn>;
+			static_assert(alignof(Command) <= commandAlignment, "Over aligned commands aren't supported");
+
+			constexpr size_t commandOffset = AlignUp(sizeof(CommandHeader), commandAlignment);
+			std::byte* memory = Allocate(commandOffset + sizeof(Command));
+
+			CommandHeader* header = ::new(memory) CommandHeader
+			{
+				[](void* command, Wrapper<ID3D11DeviceContext>* context)
+				{
+					Command& typedCommand = *static_cast<Command*>(command);
+					if(context)
+					{
+						try
+						{
+							typedCommand(*context);
+						}
+						catch(...)
+						{
+							typedCommand.~Command();
+							throw;
+						}
+					}
+					typedCommand.~Command();
+				},
+				nullptr
+			};
+			::new(memory + commandOffset) Command(std::forward<Fn>(command));
+
+			(last ? last->next : first) = header;
+			last = header;
+			commandCount++;
+		}
+
+		size_t GetCommandCount() const noexcept { return commandCount; }
+		bool Empty() const noexcept { return commandCount == 0; }
+
+	private:
+		std::byte* Allocate(size_t size)
+		{
+			size = AlignUp(size, commandAlignment);
+			for(; currentChunk < chunks.size(); currentChunk++)
+			{
+				Chunk& chunk = chunks[currentChunk];
+				if(chunk.size - chunk.used >= size)
+				{
+					std::byte* memory = chunk.memory.get() + chunk.used;
+					chunk.used += size;
+					return memory;
+				}
+			}
+
+			//Commands bigger than a chunk get a chunk of their own
+			const size_t newChunkSize = std::max(chunkSize, size);
+			chunks.push_back({ std::make_unique_for_overwrite<std::byte[]>(newChunkSize), newChunkSize, size });
+			currentChunk = chunks.size() - 1;
+			return chunks.back().memory.get();
+		}
+
+		//Runs every command on context, or destroys them without running them when context is null, and keeps the chunks for reuse.
+		//Commands are unlinked before they run, so if one throws only the commands after it are left in the batch
+		void Destroy(Wrapper<ID3D11DeviceContext>* context)
+		{
+			constexpr size_t commandOffset = AlignUp(sizeof(CommandHeader), commandAlignment);
+			while(first)
+			{
+				CommandHeader* header = std::exchange(first, first->next);
+				header->execute(reinterpret_cast<std::byte*>(header) + commandOffset, context);
+			}
+
+			first = nullptr;
+			last = nullptr;
+			commandCount = 0;
+			currentChunk = 0;
+			for(Chunk& chunk : chunks)
+				chunk.used = 0;
+		}
+	};
+
+	/// <summary>
+	/// Forwards device context calls from game threads to a single render thread which owns the immediate context.
+	/// Each game thread records into its own Recorder without synchronization, Submit publishes the batch with a single atomic operation
+	/// and the render thread's Drain runs the batches in the order they were submitted.
+	/// Unlike deferred contexts this works the same on every driver, the recorded calls run directly on the immediate context
+	/// </summary>
+	export class RenderThreadQueue
+	{
+		//Executed batches go back to the recorder that submitted them through this list, which stays alive while any of its batches are in flight
+		struct ReturnList
+		{
+			std::atomic<CommandBatch*> head = nullptr;
+
+			~ReturnList()
+			{
+				for(CommandBatch* batch = head.load(); batch;)
+					delete std::exchange(batch, batch->next);
+			}
+		};
+
+		Wrapper<ID3D11DeviceContext> immediateContext;
+		std::atomic<CommandBatch*> submitted = nullptr;
+		std::vector<CommandBatch*> draining;
+		std::atomic<size_t> executedCommands = 0;
+
+	public:
+		class Recorder
+		{
+			RenderThreadQueue* queue;
+			std::shared_ptr<ReturnList> returned = std::make_shared<ReturnList>();
+			std::vector<std::unique_ptr<CommandBatch>> freeBatches;
+			std::unique_ptr<CommandBatch> batch;
+
+		public:
+			Recorder(RenderThreadQueue& queue) :
+				queue{ &queue }
+			{
+			}
+
+			Recorder(Recorder&&) noexcept = default;
+			Recorder& operator=(Recorder&&) noexcept = default;
+
+		public:
+			template<class Fn>
+			void Enqueue(Fn&& command)
+			{
+				if(!batch)
+					batch = AcquireBatch();
+				batch->Enqueue(std::forward<Fn>(command));
+			}
+
+			/// <summary>
+			/// Publishes the commands recorded since the last submit to the render thread
+			/// </summary>
+			void Submit()
+			{
+				if(!batch || batch->Empty())
+					return;
+
+				batch->returnList = returned;
+				queue->Push(batch.release());
+			}
+
+		private:
+			std::unique_ptr<CommandBatch> AcquireBatch()
+			{
+				for(CommandBatch* reused = returned->head.exchange(nullptr, std::memory_order_acquire); reused;)
+					freeBatches.emplace_back(std::exchange(reused, reused->next));
+
+				if(freeBatches.empty())
+					return std::make_unique<CommandBatch>();
+
+				std::unique_ptr<CommandBatch> reused = std::move(freeBatches.back());
+				freeBatches.pop_back();
+				return reused;
+			}
+		};
+
+	public:
+		RenderThreadQueue(Wrapper<ID3D11DeviceContext> immediateContext) :
+			immediateContext{ std::move(immediateContext) }
+		{
+		}
+
+		RenderThreadQueue(const RenderThreadQueue&) = delete;
+		RenderThreadQueue& operator=(const RenderThreadQueue&) = delete;
+
+		~RenderThreadQueue()
+		{
+			//Batches that were never drained are destroyed without running
+			for(CommandBatch* batch = submitted.exchange(nullptr); batch;)
+				delete std::exchange(batch, batch->next);
+		}
+
+	public:
+		Recorder CreateRecorder() { return Recorder(*this); }
+
+		/// <summary>
+		/// Runs every batch submitted so far in submission order on the immediate context, only call from the render thread.
+		/// Returns the number of commands executed.
+		/// If a command throws, every command drained after it is destroyed without running before the exception is rethrown
+		/// </summary>
+		size_t Drain()
+		{
+			//Submissions are pushed onto the front of the list, reversing it restores submission order
+			draining.clear();
+			for(CommandBatch* batch = submitted.exchange(nullptr, std::memory_order_acquire); batch; batch = batch->next)
+				draining.push_back(batch);
+
+			size_t commands = 0;
+			auto it = draining.rbegin();
+			try
+			{
+				for(; it != draining.rend(); ++it)
+				{
+					commands += (*it)->GetCommandCount();
+					(*it)->Destroy(&immediateContext);
+					ReturnBatch(*it);
+				}
+			}
+			catch(...)
+			{
+				for(; it != draining.rend(); ++it)
+				{
+					(*it)->Destroy(nullptr);
+					ReturnBatch(*it);
+				}
+				draining.clear();
+				throw;
+			}
+
+			draining.clear();
+			executedCommands.fetch_add(commands, std::memory_order_relaxed);
+			return commands;
+		}
+
+		/// <summary>
+		/// Blocks the render thread until a batch has been submitted
+		/// </summary>
+		void WaitForSubmission()
+		{
+			submitted.wait(nullptr, std::memory_order_acquire);
+		}
+
+		size_t GetExecutedCommandCount() const noexcept { return executedCommands.load(std::memory_order_relaxed); }
+		Wrapper<ID3D11DeviceContext>& GetImmediateContext() noexcept { return immediateContext; }
+
+	private:
+		static void ReturnBatch(CommandBatch* batch) noexcept
+		{
+			std::shared_ptr<ReturnList> owner = std::static_pointer_cast<ReturnList>(std::move(batch->returnList));
+			batch->next = owner->head.load(std::memory_order_relaxed);
+			while(!owner->head.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		void Push(CommandBatch* batch)
+		{
+			batch->next = submitted.load(std::memory_order_relaxed);
+			while(!submitted.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed));
+			submitted.notify_one();
+		}
+	};
+}
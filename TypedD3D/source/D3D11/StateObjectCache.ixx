@@ -0,0 +1,243 @@
+module;
+
+#include <d3d11_4.h>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <gsl/pointers>
+
+export module TypedD3D11:StateObjectCache;
+import TypedD3D.Shared;
+import :Device;
+import :States;
+import :InputLayout;
+
+namespace TypedD3D::D3D11
+{
+	/// <summary>
+	/// Small, dense per type ids handed out in creation order, suitable for packing into sort keys
+	/// </summary>
+	export using StateObjectId = UINT32;
+
+	export template<class Ty>
+	struct CachedStateObject
+	{
+		StateObjectId id;
+		Wrapper<Ty> object;
+	};
+
+	/// <summary>
+	/// Returns the input signature chunk of DXBC shader bytecode, or the whole bytecode when it isn't DXBC or has no input signature.
+	/// Input layouts only depend on the signature, so shaders sharing one share their layouts
+	/// </summary>
+	export std::span<const std::byte> FindInputSignature(std::span<const std::byte> bytecode) noexcept
+	{
+		auto readUint = [&](size_t offset)
+		{
+			UINT value;
+			std::memcpy(&value, bytecode.data() + offset, sizeof(value));
+			return value;
+		};
+
+		//DXBC container: fourcc, 16 byte checksum, version, total size, chunk count, then the chunk offsets
+		constexpr size_t chunkOffsetsStart = 32;
+		if(bytecode.size() < chunkOffsetsStart || std::memcmp(bytecode.data(), "DXBC", 4) != 0)
+			return bytecode;
+
+		const UINT chunkCount = readUint(28);
+		if(chunkOffsetsStart + size_t(chunkCount) * 4 > bytecode.size())
+			return bytecode;
+
+		for(UINT i = 0; i < chunkCount; i++)
+		{
+			const size_t chunkOffset = readUint(chunkOffsetsStart + i * 4);
+			if(chunkOffset + 8 > bytecode.size())
+				return bytecode;
+
+			const std::string_view fourcc{ reinterpret_cast<const char*>(bytecode.data() + chunkOffset), 4 };
+			const size_t chunkSize = readUint(chunkOffset + 4);
+			if((fourcc == "ISGN" || fourcc == "ISG1") && chunkOffset + 8 + chunkSize <= bytecode.size())
+				return bytecode.subspan(chunkOffset, 8 + chunkSize);
+		}
+		return bytecode;
+	}
+
+	export HashKey MakeBlendKey(const D3D11_BLEND_DESC& desc)
+	{
+		//Each render target's write mask is followed by padding, so the description is appended field by field
+		HashKey key;
+		key.Append(desc.AlphaToCoverageEnable)
+			.Append(desc.IndependentBlendEnable);
+		for(const D3D11_RENDER_TARGET_BLEND_DESC& renderTarget : desc.RenderTarget)
+		{
+			key.Append(renderTarget.BlendEnable)
+				.Append(renderTarget.SrcBlend)
+				.Append(renderTarget.DestBlend)
+				.Append(renderTarget.BlendOp)
+				.Append(renderTarget.SrcBlendAlpha)
+				.Append(renderTarget.DestBlendAlpha)
+				.Append(renderTarget.BlendOpAlpha)
+				.Append(renderTarget.RenderTargetWriteMask);
+		}
+		return key;
+	}
+
+	export HashKey MakeDepthStencilKey(const D3D11_DEPTH_STENCIL_DESC& desc)
+	{
+		//The stencil masks are followed by padding, so the description is appended field by field
+		HashKey key;
+		key.Append(desc.DepthEnable)
+			.Append(desc.DepthWriteMask)
+			.Append(desc.DepthFunc)
+			.Append(desc.StencilEnable)
+			.Append(desc.StencilReadMask)
+			.Append(desc.StencilWriteMask)
+			.Append(desc.FrontFace)
+			.Append(desc.BackFace);
+		return key;
+	}
+
+	export HashKey MakeInputLayoutKey(std::span<const D3D11_INPUT_ELEMENT_DESC> inputElementDescs, std::span<const std::byte> shaderBytecode)
+	{
+		HashKey key;
+		key.Append(inputElementDescs.size());
+		for(const D3D11_INPUT_ELEMENT_DESC& element : inputElementDescs)
+		{
+			key.AppendString(element.SemanticName)
+				.Append(element.SemanticIndex)
+				.Append(element.Format)
+				.Append(element.InputSlot)
+				.Append(element.AlignedByteOffset)
+				.Append(element.InputSlotClass)
+				.Append(element.InstanceDataStepRate);
+		}
+		key.AppendBytes(FindInputSignature(shaderBytecode));
+		return key;
+	}
+
+	/// <summary>
+	/// Deduplicates blend, rasterizer, depth stencil and sampler states and input layouts on their description,
+	/// rather than relying on the runtime's own deduplication which is opaque and limited to 4096 objects per type.
+	/// Every object gets a small id that stays valid until Clear.
+	/// Thread safe
+	/// </summary>
+	export class StateObjectCache
+	{
+		template<class Ty>
+		struct Table
+		{
+			std::unordered_map<HashKey, StateObjectId, HashKeyHasher> ids;
+			std::deque<Wrapper<Ty>> objects;
+		};
+
+		Wrapper<ID3D11Device> device;
+
+		mutable std::mutex mutex;
+		Table<ID3D11BlendState> blendStates;
+		Table<ID3D11RasterizerState> rasterizerStates;
+		Table<ID3D11DepthStencilState> depthStencilStates;
+		Table<ID3D11SamplerState> samplerStates;
+		Table<ID3D11InputLayout> inputLayouts;
+
+	public:
+		StateObjectCache(Wrapper<ID3D11Device> device) :
+			device{ std::move(device) }
+		{
+		}
+
+	public:
+		CachedStateObject<ID3D11BlendState> GetOrCreateBlendState(const D3D11_BLEND_DESC& desc)
+		{
+			return GetOrCreate(blendStates, MakeBlendKey(desc), [&] { return device->CreateBlendState(desc); });
+		}
+
+		CachedStateObject<ID3D11RasterizerState> GetOrCreateRasterizerState(const D3D11_RASTERIZER_DESC& desc)
+		{
+			return GetOrCreate(rasterizerStates, HashKey{}.Append(desc), [&] { return device->CreateRasterizerState(desc); });
+		}
+
+		CachedStateObject<ID3D11DepthStencilState> GetOrCreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc)
+		{
+			return GetOrCreate(depthStencilStates, MakeDepthStencilKey(desc), [&] { return device->CreateDepthStencilState(desc); });
+		}
+
+		CachedStateObject<ID3D11SamplerState> GetOrCreateSamplerState(const D3D11_SAMPLER_DESC& desc)
+		{
+			return GetOrCreate(samplerStates, HashKey{}.Append(desc), [&] { return device->CreateSamplerState(desc); });
+		}
+
+		CachedStateObject<ID3D11InputLayout> GetOrCreateInputLayout(
+			std::span<const D3D11_INPUT_ELEMENT_DESC> inputElementDescs,
+			gsl::not_null<const void*> pShaderBytecodeWithInputSignature,
+			SIZE_T BytecodeLength)
+		{
+			const std::span bytecode{ static_cast<const std::byte*>(pShaderBytecodeWithInputSignature.get()), BytecodeLength };
+			return GetOrCreate(inputLayouts, MakeInputLayoutKey(inputElementDescs, bytecode), [&] { return device->CreateInputLayout(inputElementDescs, pShaderBytecodeWithInputSignature, BytecodeLength); });
+		}
+
+		CachedStateObject<ID3D11InputLayout> GetOrCreateInputLayout(
+			std::span<const D3D11_INPUT_ELEMENT_DESC> inputElementDescs,
+			gsl::not_null<WrapperView<ID3DBlob>> pShaderBytecodeWithInputSignature)
+		{
+			return GetOrCreateInputLayout(inputElementDescs, pShaderBytecodeWithInputSignature->GetBufferPointer(), pShaderBytecodeWithInputSignature->GetBufferSize());
+		}
+
+	public:
+		WrapperView<ID3D11BlendState> GetBlendState(StateObjectId id) const { return Get(blendStates, id); }
+		WrapperView<ID3D11RasterizerState> GetRasterizerState(StateObjectId id) const { return Get(rasterizerStates, id); }
+		WrapperView<ID3D11DepthStencilState> GetDepthStencilState(StateObjectId id) const { return Get(depthStencilStates, id); }
+		WrapperView<ID3D11SamplerState> GetSamplerState(StateObjectId id) const { return Get(samplerStates, id); }
+		WrapperView<ID3D11InputLayout> GetInputLayout(StateObjectId id) const { return Get(inputLayouts, id); }
+
+		/// <summary>
+		/// Releases every cached object, previously returned ids become invalid
+		/// </summary>
+		void Clear()
+		{
+			std::scoped_lock lock{ mutex };
+			blendStates = {};
+			rasterizerStates = {};
+			depthStencilStates = {};
+			samplerStates = {};
+			inputLayouts = {};
+		}
+
+		size_t GetObjectCount() const
+		{
+			std::scoped_lock lock{ mutex };
+			return blendStates.objects.size()
+				+ rasterizerStates.objects.size()
+				+ depthStencilStates.objects.size()
+				+ samplerStates.objects.size()
+				+ inputLayouts.objects.size();
+		}
+
+	private:
+		template<class Ty, class CreateFn>
+		CachedStateObject<Ty> GetOrCreate(Table<Ty>& table, HashKey key, CreateFn&& create)
+		{
+			std::scoped_lock lock{ mutex };
+			if(auto it = table.ids.find(key); it != table.ids.end())
+				return { it->second, table.objects[it->second] };
+
+			//Creation stays under the lock so that racing callers never end up with 2 objects and ids for the same description
+			Wrapper<Ty> object = create();
+			const StateObjectId id = static_cast<StateObjectId>(table.objects.size());
+			table.objects.push_back(object);
+			table.ids.emplace(std::move(key), id);
+			return { id, std::move(object) };
+		}
+
+		template<class Ty>
+		WrapperView<Ty> Get(const Table<Ty>& table, StateObjectId id) const
+		{
+			std::scoped_lock lock{ mutex };
+			return table.objects.at(id);
+		}
+	};
+}
@@ -357,6 +357,7 @@ namespace TypedD3D
 			{
 				const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencil = (pDepthStencilDescriptor) ? &pDepthStencilDescriptor->Raw() : nullptr;
 
+				Instrumentation::AddArgumentCount(pRenderTargetDescriptors.size());
 				Self().OMSetRenderTargets(static_cast<UINT>(pRenderTargetDescriptors.size()), pRenderTargetDescriptors.data(), RTsSingleHandleToDescriptorRange, depthStencil);
 			}
 
@@ -399,6 +400,7 @@ namespace TypedD3D
 
 			void ResourceBarrier(std::span<const D3D12_RESOURCE_BARRIER> Barriers) requires D3D12::DisableFunction<Tag, BundleTag>
 			{
+				Instrumentation::AddArgumentCount(Barriers.size());
 				Self().ResourceBarrier(static_cast<UINT>(Barriers.size()), Barriers.data());
 			}
 
@@ -462,18 +464,21 @@ namespace TypedD3D
 			void SetDescriptorHeaps(ShaderVisible<CBV_SRV_UAV<ID3D12DescriptorHeap>> descriptorHeap) requires D3D12::DisableFunction<Tag, CopyTag>
 			{
 				ID3D12DescriptorHeap* heaps[] = { descriptorHeap.Get() };
+				Instrumentation::AddArgumentCount(1);
 				Self().SetDescriptorHeaps(1, heaps);
 			}
 
 			void SetDescriptorHeaps(ShaderVisible<Sampler<ID3D12DescriptorHeap>> descriptorHeap) requires D3D12::DisableFunction<Tag, CopyTag>
 			{
 				ID3D12DescriptorHeap* heaps[] = { descriptorHeap.Get() };
+				Instrumentation::AddArgumentCount(1);
 				Self().SetDescriptorHeaps(1, heaps);
 			}
 
 			void SetDescriptorHeaps(ShaderVisible<CBV_SRV_UAV<ID3D12DescriptorHeap>> cbv_srv_uavHeap, ShaderVisible<Sampler<ID3D12DescriptorHeap>> samplerHeap) requires D3D12::DisableFunction<Tag, CopyTag>
 			{
 				ID3D12DescriptorHeap* heaps[] = { cbv_srv_uavHeap.Get(), samplerHeap.Get() };
+				Instrumentation::AddArgumentCount(2);
 				Self().SetDescriptorHeaps(2, heaps);
 			}
 
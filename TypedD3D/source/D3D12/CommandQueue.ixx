@@ -141,6 +141,7 @@ namespace TypedD3D
 
 			void ExecuteCommandLists(Span<WeakWrapper<Tag<ID3D12CommandList>>> commandLists)
 			{
+				Instrumentation::AddArgumentCount(commandLists.size());
 				Self().ExecuteCommandLists(static_cast<UINT>(commandLists.size()), commandLists.data());
 			}
 
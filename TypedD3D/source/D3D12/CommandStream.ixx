@@ -0,0 +1,583 @@
+module;
+
+#include <d3d12.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <gsl/pointers>
+
+export module TypedD3D12:CommandStream;
+import TypedD3D.Shared;
+import :Wrappers;
+import :DescriptorHeap;
+
+namespace TypedD3D::D3D12
+{
+	export enum class CommandId : UINT32
+	{
+		SetPipelineState,
+		SetGraphicsRootSignature,
+		SetComputeRootSignature,
+		SetDescriptorHeaps,
+		IASetPrimitiveTopology,
+		IASetIndexBuffer,
+		IASetVertexBuffers,
+		RSSetViewports,
+		RSSetScissorRects,
+		OMSetRenderTargets,
+		OMSetStencilRef,
+		OMSetBlendFactor,
+		ClearRenderTargetView,
+		ClearDepthStencilView,
+		SetGraphicsRoot32BitConstants,
+		SetComputeRoot32BitConstants,
+		SetGraphicsRootConstantBufferView,
+		SetComputeRootConstantBufferView,
+		SetGraphicsRootShaderResourceView,
+		SetComputeRootShaderResourceView,
+		SetGraphicsRootUnorderedAccessView,
+		SetComputeRootUnorderedAccessView,
+		SetGraphicsRootDescriptorTable,
+		SetComputeRootDescriptorTable,
+		DrawInstanced,
+		DrawIndexedInstanced,
+		Dispatch,
+		ExecuteIndirect,
+		ResourceBarrier,
+		CopyBufferRegion,
+		CopyResource,
+	};
+
+	/// <summary>
+	/// Records graphics command list calls into a packed, linear byte stream without making any COM calls, so commands can be recorded on any thread before a command allocator is available.
+	/// The functions mirror the typed graphics command list, Replay plays the commands back onto a real list, or anything exposing the same functions through operator->.
+	/// Streams can be appended to each other to merge them. Objects referenced by the commands aren't kept alive and must outlive the replay
+	/// </summary>
+	export class CommandStream
+	{
+		static constexpr size_t commandAlignment = 8;
+
+		struct CommandHeader
+		{
+			CommandId id;
+
+			//Size of the header, the packet and its trailing elements, a multiple of commandAlignment
+			UINT32 size;
+		};
+
+		struct ObjectPacket { void* object; };
+		struct ValuePacket { UINT value; };
+		struct BlendFactorPacket { std::array<float, 4> factor; };
+		struct DescriptorHeapsPacket { ID3D12DescriptorHeap* cbvSrvUav; ID3D12DescriptorHeap* sampler; };
+		struct IndexBufferPacket { D3D12_INDEX_BUFFER_VIEW view; BOOL hasView; };
+		struct ElementsPacket { UINT startSlot; UINT count; };
+		struct RenderTargetsPacket { UINT renderTargetCount; BOOL singleHandleToDescriptorRange; BOOL hasDepthStencil; D3D12_CPU_DESCRIPTOR_HANDLE depthStencil; };
+		struct ClearRenderTargetPacket { D3D12_CPU_DESCRIPTOR_HANDLE view; std::array<float, 4> color; UINT rectCount; };
+		struct ClearDepthStencilPacket { D3D12_CPU_DESCRIPTOR_HANDLE view; D3D12_CLEAR_FLAGS flags; FLOAT depth; UINT8 stencil; UINT rectCount; };
+		struct RootConstantsPacket { UINT rootParameterIndex; UINT count; UINT destOffset; };
+		struct RootAddressPacket { UINT rootParameterIndex; D3D12_GPU_VIRTUAL_ADDRESS address; };
+		struct RootTablePacket { UINT rootParameterIndex; D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor; };
+		struct DrawPacket { UINT countPerInstance; UINT instanceCount; UINT startLocation; INT baseVertexLocation; UINT startInstanceLocation; };
+		struct DispatchPacket { UINT x; UINT y; UINT z; };
+		struct ExecuteIndirectPacket { ID3D12CommandSignature* signature; UINT maxCommandCount; ID3D12Resource* argumentBuffer; UINT64 argumentBufferOffset; ID3D12Resource* countBuffer; UINT64 countBufferOffset; };
+		struct CopyBufferRegionPacket { ID3D12Resource* dst; UINT64 dstOffset; ID3D12Resource* src; UINT64 srcOffset; UINT64 numBytes; };
+		struct CopyResourcePacket { ID3D12Resource* dst; ID3D12Resource* src; };
+
+		std::vector<std::byte> bytes;
+		size_t commandCount = 0;
+
+	public:
+		CommandStream() = default;
+
+	public:
+		void SetPipelineState(WrapperView<ID3D12PipelineState> pPipelineState)
+		{
+			Push(CommandId::SetPipelineState, ObjectPacket{ pPipelineState.Get() });
+		}
+
+		void SetGraphicsRootSignature(WrapperView<ID3D12RootSignature> pRootSignature)
+		{
+			Push(CommandId::SetGraphicsRootSignature, ObjectPacket{ pRootSignature.Get() });
+		}
+
+		void SetComputeRootSignature(WrapperView<ID3D12RootSignature> pRootSignature)
+		{
+			Push(CommandId::SetComputeRootSignature, ObjectPacket{ pRootSignature.Get() });
+		}
+
+		void SetDescriptorHeaps(const ShaderVisible<CBV_SRV_UAV<ID3D12DescriptorHeap>>& descriptorHeap)
+		{
+			Push(CommandId::SetDescriptorHeaps, DescriptorHeapsPacket{ descriptorHeap.Get(), nullptr });
+		}
+
+		void SetDescriptorHeaps(const ShaderVisible<Sampler<ID3D12DescriptorHeap>>& descriptorHeap)
+		{
+			Push(CommandId::SetDescriptorHeaps, DescriptorHeapsPacket{ nullptr, descriptorHeap.Get() });
+		}
+
+		void SetDescriptorHeaps(const ShaderVisible<CBV_SRV_UAV<ID3D12DescriptorHeap>>& cbv_srv_uavHeap, const ShaderVisible<Sampler<ID3D12DescriptorHeap>>& samplerHeap)
+		{
+			Push(CommandId::SetDescriptorHeaps, DescriptorHeapsPacket{ cbv_srv_uavHeap.Get(), samplerHeap.Get() });
+		}
+
+		void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology)
+		{
+			Push(CommandId::IASetPrimitiveTopology, ValuePacket{ static_cast<UINT>(PrimitiveTopology) });
+		}
+
+		void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView)
+		{
+			Push(CommandId::IASetIndexBuffer, IndexBufferPacket{ pView ? *pView : D3D12_INDEX_BUFFER_VIEW{}, pView != nullptr });
+		}
+
+		void IASetVertexBuffers(UINT StartSlot, std::span<const D3D12_VERTEX_BUFFER_VIEW> views)
+		{
+			Push(CommandId::IASetVertexBuffers, ElementsPacket{ StartSlot, static_cast<UINT>(views.size()) }, views);
+		}
+
+		void RSSetViewports(std::span<const D3D12_VIEWPORT> viewports)
+		{
+			if(viewports.size() > D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE)
+				throw std::invalid_argument("At most 16 viewports can be set");
+			Push(CommandId::RSSetViewports, ElementsPacket{ 0, static_cast<UINT>(viewports.size()) }, viewports);
+		}
+
+		void RSSetScissorRects(std::span<const D3D12_RECT> rects)
+		{
+			if(rects.size() > D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE)
+				throw std::invalid_argument("At most 16 scissor rects can be set");
+			Push(CommandId::RSSetScissorRects, ElementsPacket{ 0, static_cast<UINT>(rects.size()) }, rects);
+		}
+
+		void OMSetRenderTargets(
+			Span<const RTV<D3D12_CPU_DESCRIPTOR_HANDLE>> pRenderTargetDescriptors,
+			BOOL RTsSingleHandleToDescriptorRange,
+			const DSV<D3D12_CPU_DESCRIPTOR_HANDLE>* pDepthStencilDescriptor)
+		{
+			if(pRenderTargetDescriptors.size() > D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT)
+				throw std::invalid_argument("At most 8 render targets can be set");
+			const size_t storedHandles = RTsSingleHandleToDescriptorRange ? std::min<size_t>(pRenderTargetDescriptors.size(), 1) : pRenderTargetDescriptors.size();
+
+			Push(
+				CommandId::OMSetRenderTargets,
+				RenderTargetsPacket
+				{
+					static_cast<UINT>(pRenderTargetDescriptors.size()),
+					RTsSingleHandleToDescriptorRange,
+					pDepthStencilDescriptor != nullptr,
+					pDepthStencilDescriptor ? pDepthStencilDescriptor->Raw() : D3D12_CPU_DESCRIPTOR_HANDLE{}
+				},
+				std::span<const D3D12_CPU_DESCRIPTOR_HANDLE>(pRenderTargetDescriptors.data(), storedHandles));
+		}
+
+		void OMSetStencilRef(UINT StencilRef)
+		{
+			Push(CommandId::OMSetStencilRef, ValuePacket{ StencilRef });
+		}
+
+		void OMSetBlendFactor(std::span<const float, 4> BlendFactor)
+		{
+			BlendFactorPacket packet;
+			std::ranges::copy(BlendFactor, packet.factor.begin());
+			Push(CommandId::OMSetBlendFactor, packet);
+		}
+
+		void ClearRenderTargetView(
+			RTV<D3D12_CPU_DESCRIPTOR_HANDLE> RenderTargetView,
+			std::span<const float, 4> colorRGBA,
+			std::span<const D3D12_RECT> rects)
+		{
+			ClearRenderTargetPacket packet{ RenderTargetView.Raw(), {}, static_cast<UINT>(rects.size()) };
+			std::ranges::copy(colorRGBA, packet.color.begin());
+			Push(CommandId::ClearRenderTargetView, packet, rects);
+		}
+
+		void ClearRenderTargetView(
+			RTV<D3D12_CPU_DESCRIPTOR_HANDLE> RenderTargetView,
+			const std::array<float, 4>& colorRGBA)
+		{
+			ClearRenderTargetView(RenderTargetView, colorRGBA, {});
+		}
+
+		void ClearDepthStencilView(
+			DSV<D3D12_CPU_DESCRIPTOR_HANDLE> DepthStencilView,
+			D3D12_CLEAR_FLAGS ClearFlags,
+			FLOAT Depth,
+			UINT8 Stencil,
+			std::span<const D3D12_RECT> rects)
+		{
+			Push(CommandId::ClearDepthStencilView, ClearDepthStencilPacket{ DepthStencilView.Raw(), ClearFlags, Depth, Stencil, static_cast<UINT>(rects.size()) }, rects);
+		}
+
+		void SetGraphicsRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues)
+		{
+			SetGraphicsRoot32BitConstants(RootParameterIndex, 1, &SrcData, DestOffsetIn32BitValues);
+		}
+
+		void SetGraphicsRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData, UINT DestOffsetIn32BitValues)
+		{
+			Push(CommandId::SetGraphicsRoot32BitConstants, RootConstantsPacket{ RootParameterIndex, Num32BitValuesToSet, DestOffsetIn32BitValues }, std::span(static_cast<const UINT32*>(pSrcData), Num32BitValuesToSet));
+		}
+
+		void SetComputeRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues)
+		{
+			SetComputeRoot32BitConstants(RootParameterIndex, 1, &SrcData, DestOffsetIn32BitValues);
+		}
+
+		void SetComputeRoot32BitConstants(UINT RootParameterIndex, UINT Num32BitValuesToSet, const void* pSrcData, UINT DestOffsetIn32BitValues)
+		{
+			Push(CommandId::SetComputeRoot32BitConstants, RootConstantsPacket{ RootParameterIndex, Num32BitValuesToSet, DestOffsetIn32BitValues }, std::span(static_cast<const UINT32*>(pSrcData), Num32BitValuesToSet));
+		}
+
+		void SetGraphicsRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+		{
+			Push(CommandId::SetGraphicsRootConstantBufferView, RootAddressPacket{ RootParameterIndex, BufferLocation });
+		}
+
+		void SetComputeRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+		{
+			Push(CommandId::SetComputeRootConstantBufferView, RootAddressPacket{ RootParameterIndex, BufferLocation });
+		}
+
+		void SetGraphicsRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+		{
+			Push(CommandId::SetGraphicsRootShaderResourceView, RootAddressPacket{ RootParameterIndex, BufferLocation });
+		}
+
+		void SetComputeRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+		{
+			Push(CommandId::SetComputeRootShaderResourceView, RootAddressPacket{ RootParameterIndex, BufferLocation });
+		}
+
+		void SetGraphicsRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+		{
+			Push(CommandId::SetGraphicsRootUnorderedAccessView, RootAddressPacket{ RootParameterIndex, BufferLocation });
+		}
+
+		void SetComputeRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
+		{
+			Push(CommandId::SetComputeRootUnorderedAccessView, RootAddressPacket{ RootParameterIndex, BufferLocation });
+		}
+
+		void SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor)
+		{
+			Push(CommandId::SetGraphicsRootDescriptorTable, RootTablePacket{ RootParameterIndex, BaseDescriptor });
+		}
+
+		void SetComputeRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor)
+		{
+			Push(CommandId::SetComputeRootDescriptorTable, RootTablePacket{ RootParameterIndex, BaseDescriptor });
+		}
+
+		void DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation)
+		{
+			Push(CommandId::DrawInstanced, DrawPacket{ VertexCountPerInstance, InstanceCount, StartVertexLocation, 0, StartInstanceLocation });
+		}
+
+		void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation)
+		{
+			Push(CommandId::DrawIndexedInstanced, DrawPacket{ IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation });
+		}
+
+		void Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ)
+		{
+			Push(CommandId::Dispatch, DispatchPacket{ ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ });
+		}
+
+		void ExecuteIndirect(
+			gsl::not_null<WrapperView<ID3D12CommandSignature>> commandSignature,
+			UINT maxCommandCount,
+			gsl::not_null<WrapperView<ID3D12Resource>> argumentBuffer,
+			UINT64 argumentBufferOffset,
+			WrapperView<ID3D12Resource> optCountBuffer = nullptr,
+			UINT64 optCountBufferOffset = 0)
+		{
+			Push(CommandId::ExecuteIndirect, ExecuteIndirectPacket{ commandSignature.get().Get(), maxCommandCount, argumentBuffer.get().Get(), argumentBufferOffset, optCountBuffer.Get(), optCountBufferOffset });
+		}
+
+		void ResourceBarrier(std::span<const D3D12_RESOURCE_BARRIER> Barriers)
+		{
+			Push(CommandId::ResourceBarrier, ElementsPacket{ 0, static_cast<UINT>(Barriers.size()) }, Barriers);
+		}
+
+		void CopyBufferRegion(
+			gsl::not_null<WrapperView<ID3D12Resource>> pDstBuffer,
+			UINT64 DstOffset,
+			gsl::not_null<WrapperView<ID3D12Resource>> pSrcBuffer,
+			UINT64 SrcOffset,
+			UINT64 NumBytes)
+		{
+			Push(CommandId::CopyBufferRegion, CopyBufferRegionPacket{ pDstBuffer.get().Get(), DstOffset, pSrcBuffer.get().Get(), SrcOffset, NumBytes });
+		}
+
+		void CopyResource(
+			gsl::not_null<WrapperView<ID3D12Resource>> pDstResource,
+			gsl::not_null<WrapperView<ID3D12Resource>> pSrcResource)
+		{
+			Push(CommandId::CopyResource, CopyResourcePacket{ pDstResource.get().Get(), pSrcResource.get().Get() });
+		}
+
+	public:
+		/// <summary>
+		/// Appends the commands of other after the commands of this stream
+		/// </summary>
+		void Append(const CommandStream& other)
+		{
+			bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end());
+			commandCount += other.commandCount;
+		}
+
+		void Clear() noexcept
+		{
+			bytes.clear();
+			commandCount = 0;
+		}
+
+		void Reserve(size_t byteCount) { bytes.reserve(byteCount); }
+
+		size_t GetCommandCount() const noexcept { return commandCount; }
+		size_t GetSizeInBytes() const noexcept { return bytes.size(); }
+		bool Empty() const noexcept { return commandCount == 0; }
+
+		/// <summary>
+		/// Returns the id of every recorded command in order
+		/// </summary>
+		std::vector<CommandId> GetCommandIds() const
+		{
+			std::vector<CommandId> ids;
+			ids.reserve(commandCount);
+			for(size_t offset = 0; offset < bytes.size(); offset += HeaderAt(offset).size)
+				ids.push_back(HeaderAt(offset).id);
+			return ids;
+		}
+
+		/// <summary>
+		/// Plays every recorded command back in order.
+		/// ListTy is a typed command list, or anything with the same functions reachable through operator->
+		/// </summary>
+		template<class ListTy>
+		void Replay(ListTy& commandList) const
+		{
+			for(size_t offset = 0; offset < bytes.size();)
+			{
+				const CommandHeader& header = HeaderAt(offset);
+				const std::byte* payload = bytes.data() + offset + sizeof(CommandHeader);
+				offset += header.size;
+
+				switch(header.id)
+				{
+				case CommandId::SetPipelineState:
+					commandList->SetPipelineState(WrapperView<ID3D12PipelineState>(static_cast<ID3D12PipelineState*>(PacketAt<ObjectPacket>(payload).object)));
+					break;
+				case CommandId::SetGraphicsRootSignature:
+					commandList->SetGraphicsRootSignature(WrapperView<ID3D12RootSignature>(static_cast<ID3D12RootSignature*>(PacketAt<ObjectPacket>(payload).object)));
+					break;
+				case CommandId::SetComputeRootSignature:
+					commandList->SetComputeRootSignature(WrapperView<ID3D12RootSignature>(static_cast<ID3D12RootSignature*>(PacketAt<ObjectPacket>(payload).object)));
+					break;
+				case CommandId::SetDescriptorHeaps:
+				{
+					const auto& packet = PacketAt<DescriptorHeapsPacket>(payload);
+					if(packet.cbvSrvUav && packet.sampler)
+						commandList->SetDescriptorHeaps(ShaderVisible<CBV_SRV_UAV<ID3D12DescriptorHeap>>(packet.cbvSrvUav), ShaderVisible<Sampler<ID3D12DescriptorHeap>>(packet.sampler));
+					else if(packet.cbvSrvUav)
+						commandList->SetDescriptorHeaps(ShaderVisible<CBV_SRV_UAV<ID3D12DescriptorHeap>>(packet.cbvSrvUav));
+					else
+						commandList->SetDescriptorHeaps(ShaderVisible<Sampler<ID3D12DescriptorHeap>>(packet.sampler));
+					break;
+				}
+				case CommandId::IASetPrimitiveTopology:
+					commandList->IASetPrimitiveTopology(static_cast<D3D12_PRIMITIVE_TOPOLOGY>(PacketAt<ValuePacket>(payload).value));
+					break;
+				case CommandId::IASetIndexBuffer:
+				{
+					const auto& packet = PacketAt<IndexBufferPacket>(payload);
+					commandList->IASetIndexBuffer(packet.hasView ? &packet.view : nullptr);
+					break;
+				}
+				case CommandId::IASetVertexBuffers:
+				{
+					const auto& packet = PacketAt<ElementsPacket>(payload);
+					commandList->IASetVertexBuffers(packet.startSlot, ElementsAt<ElementsPacket, D3D12_VERTEX_BUFFER_VIEW>(payload, packet.count));
+					break;
+				}
+				case CommandId::RSSetViewports:
+				{
+					//The typed list takes mutable spans, so the elements are copied out of the stream
+					const auto& packet = PacketAt<ElementsPacket>(payload);
+					std::array<D3D12_VIEWPORT, D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE> viewports;
+					std::ranges::copy(ElementsAt<ElementsPacket, D3D12_VIEWPORT>(payload, packet.count), viewports.begin());
+					commandList->RSSetViewports(std::span(viewports.data(), packet.count));
+					break;
+				}
+				case CommandId::RSSetScissorRects:
+				{
+					const auto& packet = PacketAt<ElementsPacket>(payload);
+					std::array<D3D12_RECT, D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE> rects;
+					std::ranges::copy(ElementsAt<ElementsPacket, D3D12_RECT>(payload, packet.count), rects.begin());
+					commandList->RSSetScissorRects(std::span(rects.data(), packet.count));
+					break;
+				}
+				case CommandId::OMSetRenderTargets:
+				{
+					const auto& packet = PacketAt<RenderTargetsPacket>(payload);
+					const UINT storedHandles = packet.singleHandleToDescriptorRange ? std::min(packet.renderTargetCount, 1u) : packet.renderTargetCount;
+					std::array<D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT> renderTargets{};
+					std::ranges::copy(ElementsAt<RenderTargetsPacket, D3D12_CPU_DESCRIPTOR_HANDLE>(payload, storedHandles), renderTargets.begin());
+
+					const DSV<D3D12_CPU_DESCRIPTOR_HANDLE> depthStencil = packet.depthStencil;
+					commandList->OMSetRenderTargets(
+						Span<const RTV<D3D12_CPU_DESCRIPTOR_HANDLE>>(renderTargets.data(), packet.renderTargetCount),
+						packet.singleHandleToDescriptorRange,
+						packet.hasDepthStencil ? &depthStencil : nullptr);
+					break;
+				}
+				case CommandId::OMSetStencilRef:
+					commandList->OMSetStencilRef(PacketAt<ValuePacket>(payload).value);
+					break;
+				case CommandId::OMSetBlendFactor:
+					commandList->OMSetBlendFactor(std::span<const float, 4>(PacketAt<BlendFactorPacket>(payload).factor));
+					break;
+				case CommandId::ClearRenderTargetView:
+				{
+					const auto& packet = PacketAt<ClearRenderTargetPacket>(payload);
+					commandList->ClearRenderTargetView(RTV<D3D12_CPU_DESCRIPTOR_HANDLE>(packet.view), std::span<const float, 4>(packet.color), ElementsAt<ClearRenderTargetPacket, D3D12_RECT>(payload, packet.rectCount));
+					break;
+				}
+				case CommandId::ClearDepthStencilView:
+				{
+					const auto& packet = PacketAt<ClearDepthStencilPacket>(payload);
+					commandList->ClearDepthStencilView(DSV<D3D12_CPU_DESCRIPTOR_HANDLE>(packet.view), packet.flags, packet.depth, packet.stencil, ElementsAt<ClearDepthStencilPacket, D3D12_RECT>(payload, packet.rectCount));
+					break;
+				}
+				case CommandId::SetGraphicsRoot32BitConstants:
+				{
+					const auto& packet = PacketAt<RootConstantsPacket>(payload);
+					commandList->SetGraphicsRoot32BitConstants(packet.rootParameterIndex, packet.count, ElementsAt<RootConstantsPacket, UINT32>(payload, packet.count).data(), packet.destOffset);
+					break;
+				}
+				case CommandId::SetComputeRoot32BitConstants:
+				{
+					const auto& packet = PacketAt<RootConstantsPacket>(payload);
+					commandList->SetComputeRoot32BitConstants(packet.rootParameterIndex, packet.count, ElementsAt<RootConstantsPacket, UINT32>(payload, packet.count).data(), packet.destOffset);
+					break;
+				}
+				case CommandId::SetGraphicsRootConstantBufferView:
+					commandList->SetGraphicsRootConstantBufferView(PacketAt<RootAddressPacket>(payload).rootParameterIndex, PacketAt<RootAddressPacket>(payload).address);
+					break;
+				case CommandId::SetComputeRootConstantBufferView:
+					commandList->SetComputeRootConstantBufferView(PacketAt<RootAddressPacket>(payload).rootParameterIndex, PacketAt<RootAddressPacket>(payload).address);
+					break;
+				case CommandId::SetGraphicsRootShaderResourceView:
+					commandList->SetGraphicsRootShaderResourceView(PacketAt<RootAddressPacket>(payload).rootParameterIndex, PacketAt<RootAddressPacket>(payload).address);
+					break;
+				case CommandId::SetComputeRootShaderResourceView:
+					commandList->SetComputeRootShaderResourceView(PacketAt<RootAddressPacket>(payload).rootParameterIndex, PacketAt<RootAddressPacket>(payload).address);
+					break;
+				case CommandId::SetGraphicsRootUnorderedAccessView:
+					commandList->SetGraphicsRootUnorderedAccessView(PacketAt<RootAddressPacket>(payload).rootParameterIndex, PacketAt<RootAddressPacket>(payload).address);
+					break;
+				case CommandId::SetComputeRootUnorderedAccessView:
+					commandList->SetComputeRootUnorderedAccessView(PacketAt<RootAddressPacket>(payload).rootParameterIndex, PacketAt<RootAddressPacket>(payload).address);
+					break;
+				case CommandId::SetGraphicsRootDescriptorTable:
+					commandList->SetGraphicsRootDescriptorTable(PacketAt<RootTablePacket>(payload).rootParameterIndex, PacketAt<RootTablePacket>(payload).baseDescriptor);
+					break;
+				case CommandId::SetComputeRootDescriptorTable:
+					commandList->SetComputeRootDescriptorTable(PacketAt<RootTablePacket>(payload).rootParameterIndex, PacketAt<RootTablePacket>(payload).baseDescriptor);
+					break;
+				case CommandId::DrawInstanced:
+				{
+					const auto& packet = PacketAt<DrawPacket>(payload);
+					commandList->DrawInstanced(packet.countPerInstance, packet.instanceCount, packet.startLocation, packet.startInstanceLocation);
+					break;
+				}
+				case CommandId::DrawIndexedInstanced:
+				{
+					const auto& packet = PacketAt<DrawPacket>(payload);
+					commandList->DrawIndexedInstanced(packet.countPerInstance, packet.instanceCount, packet.startLocation, packet.baseVertexLocation, packet.startInstanceLocation);
+					break;
+				}
+				case CommandId::Dispatch:
+				{
+					const auto& packet = PacketAt<DispatchPacket>(payload);
+					commandList->Dispatch(packet.x, packet.y, packet.z);
+					break;
+				}
+				case CommandId::ExecuteIndirect:
+				{
+					const auto& packet = PacketAt<ExecuteIndirectPacket>(payload);
+					commandList->ExecuteIndirect(
+						WrapperView<ID3D12CommandSignature>(packet.signature),
+						packet.maxCommandCount,
+						WrapperView<ID3D12Resource>(packet.argumentBuffer),
+						packet.argumentBufferOffset,
+						WrapperView<ID3D12Resource>(packet.countBuffer),
+						packet.countBufferOffset);
+					break;
+				}
+				case CommandId::ResourceBarrier:
+					commandList->ResourceBarrier(ElementsAt<ElementsPacket, D3D12_RESOURCE_BARRIER>(payload, PacketAt<ElementsPacket>(payload).count));
+					break;
+				case CommandId::CopyBufferRegion:
+				{
+					const auto& packet = PacketAt<CopyBufferRegionPacket>(payload);
+					commandList->CopyBufferRegion(WrapperView<ID3D12Resource>(packet.dst), packet.dstOffset, WrapperView<ID3D12Resource>(packet.src), packet.srcOffset, packet.numBytes);
+					break;
+				}
+				case CommandId::CopyResource:
+				{
+					const auto& packet = PacketAt<CopyResourcePacket>(payload);
+					commandList->CopyResource(WrapperView<ID3D12Resource>(packet.dst), WrapperView<ID3D12Resource>(packet.src));
+					break;
+				}
+				default:
+					assert(false && "Unknown command in the stream");
+				}
+			}
+		}
+
+	private:
+		template<class Packet, class Element = std::byte>
+		void Push(CommandId id, const Packet& packet, std::span<const Element> elements = {})
+		{
+			static_assert(std::is_trivially_copyable_v<Packet> && std::is_trivially_copyable_v<Element>);
+			static_assert(alignof(Packet) <= commandAlignment && alignof(Element) <= commandAlignment);
+
+			const size_t elementOffset = sizeof(CommandHeader) + AlignUp(sizeof(Packet), commandAlignment);
+			const CommandHeader header{ id, static_cast<UINT32>(AlignUp(elementOffset + elements.size_bytes(), commandAlignment)) };
+
+			const size_t offset = bytes.size();
+			bytes.resize(offset + header.size);
+			std::memcpy(bytes.data() + offset, &header, sizeof(header));
+			std::memcpy(bytes.data() + offset + sizeof(CommandHeader), &packet, sizeof(packet));
+			if(!elements.empty())
+				std::memcpy(bytes.data() + offset + elementOffset, elements.data(), elements.size_bytes());
+
+			commandCount++;
+		}
+
+		const CommandHeader& HeaderAt(size_t offset) const
+		{
+			return *reinterpret_cast<const CommandHeader*>(bytes.data() + offset);
+		}
+
+		template<class Packet>
+		static const Packet& PacketAt(const std::byte* payload)
+		{
+			return *reinterpret_cast<const Packet*>(payload);
+		}
+
+		template<class Packet, class Element>
+		static std::span<const Element> ElementsAt(const std::byte* payload, size_t count)
+		{
+			return { reinterpret_cast<const Element*>(payload + AlignUp(sizeof(Packet), commandAlignment)), count };
+		}
+	};
+}
@@ -0,0 +1,96 @@
+module;
+
+#include <d3d12.h>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <gsl/pointers>
+
+export module TypedD3D12:ConstantBufferAllocator;
+import TypedD3D.Shared;
+import :Device;
+import :UploadRingAllocator;
+
+namespace TypedD3D::D3D12
+{
+	/// <summary>
+	/// Packs per draw constant data into upload pages at D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT.
+	/// The returned GPU virtual addresses are meant to be bound directly with Set*RootConstantBufferView, without creating a CBV per allocation.
+	/// Retire and Reclaim follow the same rules as UploadRingAllocator
+	/// </summary>
+	export class ConstantBufferAllocator
+	{
+	public:
+		static constexpr UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+		class ThreadContext
+		{
+			UploadRingAllocator::ThreadContext context;
+
+		public:
+			ThreadContext() = default;
+			ThreadContext(UploadRingAllocator::ThreadContext context) :
+				context{ std::move(context) }
+			{
+			}
+
+		public:
+			/// <summary>
+			/// Reserves size bytes of constant data, rounded up to a multiple of D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT
+			/// </summary>
+			UploadAllocation Allocate(UINT64 size)
+			{
+				return context.Allocate(AlignUp(size, alignment), alignment);
+			}
+
+			D3D12_GPU_VIRTUAL_ADDRESS Push(const void* data, UINT64 size)
+			{
+				UploadAllocation allocation = Allocate(size);
+				std::memcpy(allocation.cpuAddress, data, size);
+				return allocation.gpuAddress;
+			}
+
+			template<class Ty>
+				requires std::is_trivially_copyable_v<Ty>
+			D3D12_GPU_VIRTUAL_ADDRESS Push(const Ty& constants)
+			{
+				return Push(&constants, sizeof(Ty));
+			}
+
+			void Reset() { context.Reset(); }
+		};
+
+	private:
+		UploadRingAllocator allocator;
+
+	public:
+		ConstantBufferAllocator(Wrapper<ID3D12Device> device, UINT64 pageSize = UploadRingAllocator::defaultPageSize, UINT64 blockSize = UploadRingAllocator::defaultBlockSize) :
+			allocator{ std::move(device), pageSize, blockSize }
+		{
+		}
+
+	public:
+		ThreadContext CreateContext() { return { allocator.CreateContext() }; }
+
+		D3D12_GPU_VIRTUAL_ADDRESS Push(const void* data, UINT64 size)
+		{
+			UploadAllocation allocation = allocator.Allocate(AlignUp(size, alignment), alignment);
+			std::memcpy(allocation.cpuAddress, data, size);
+			return allocation.gpuAddress;
+		}
+
+		template<class Ty>
+			requires std::is_trivially_copyable_v<Ty>
+		D3D12_GPU_VIRTUAL_ADDRESS Push(const Ty& constants)
+		{
+			return Push(&constants, sizeof(Ty));
+		}
+
+		void Retire(UINT64 fenceValue) { allocator.Retire(fenceValue); }
+		void Reclaim(UINT64 completedFenceValue) { allocator.Reclaim(completedFenceValue); }
+		void Reclaim(gsl::not_null<WrapperView<ID3D12Fence>> fence) { allocator.Reclaim(fence); }
+
+		UploadRingAllocator& GetUploadAllocator() noexcept { return allocator; }
+	};
+}
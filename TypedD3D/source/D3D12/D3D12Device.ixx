@@ -494,6 +494,7 @@ namespace TypedD3D
 				const UINT* pSrcDescriptorRangeSizes,
 				D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType)
 			{
+				Instrumentation::AddArgumentCount(NumDestDescriptorRanges);
 				Self().CopyDescriptors(
 					NumDestDescriptorRanges,
 					pDestDescriptorRangeStarts,
@@ -510,6 +511,7 @@ namespace TypedD3D
 				TypedStruct<Tag<D3D12_CPU_DESCRIPTOR_HANDLE>> DestDescriptorRangeStart,
 				TypedStruct<Tag<D3D12_CPU_DESCRIPTOR_HANDLE>> SrcDescriptorRangeStart)
 			{
+				Instrumentation::AddArgumentCount(NumDescriptors);
 				Self().CopyDescriptorsSimple(NumDescriptors, DestDescriptorRangeStart.Raw(), SrcDescriptorRangeStart.Raw(), D3D12::DescriptorHeapTraitToType<Tag<D3D12_CPU_DESCRIPTOR_HANDLE>>);
 			}
 
@@ -519,6 +521,7 @@ namespace TypedD3D
 				TypedStruct<ShaderVisibleTag<Tag<D3D12_CPU_DESCRIPTOR_HANDLE>>> DestDescriptorRangeStart,
 				TypedStruct<Tag<D3D12_CPU_DESCRIPTOR_HANDLE>> SrcDescriptorRangeStart)
 			{
+				Instrumentation::AddArgumentCount(NumDescriptors);
 				Self().CopyDescriptorsSimple(NumDescriptors, DestDescriptorRangeStart.Raw(), SrcDescriptorRangeStart.Raw(), D3D12::DescriptorHeapTraitToType<Tag<D3D12_CPU_DESCRIPTOR_HANDLE>>);
 			}
 
@@ -858,7 +861,7 @@ namespace TypedD3D
 					Flags,
 					static_cast<UINT>(ppObjects.size()),
 					ppObjects.data(),
-					pFenceToSignal.get().Self(), FenceValueToSignal));
+					pFenceToSignal.get().Get(), FenceValueToSignal));
 			}
 
 		private:
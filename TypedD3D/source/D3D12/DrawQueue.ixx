@@ -0,0 +1,349 @@
+module;
+
+#include <d3d12.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+export module TypedD3D12:DrawQueue;
+import TypedD3D.Shared;
+import :Wrappers;
+
+namespace TypedD3D::D3D12
+{
+	/// <summary>
+	/// Draw keys sort by root signature, then pipeline state, then material, then depth.
+	/// From the most significant bit: 8 bits of root signature id, 16 bits of pipeline state id, 16 bits of material id and 24 bits of depth
+	/// </summary>
+	export struct DrawKeyFields
+	{
+		UINT32 rootSignature = 0;
+		UINT32 pipelineState = 0;
+		UINT32 material = 0;
+		UINT32 depth = 0;
+
+		static constexpr UINT depthBits = 24;
+		static constexpr UINT materialBits = 16;
+		static constexpr UINT pipelineStateBits = 16;
+		static constexpr UINT rootSignatureBits = 8;
+
+		static constexpr UINT materialShift = depthBits;
+		static constexpr UINT pipelineStateShift = materialShift + materialBits;
+		static constexpr UINT rootSignatureShift = pipelineStateShift + pipelineStateBits;
+
+		static constexpr UINT64 depthMask = (UINT64(1) << depthBits) - 1;
+		static constexpr UINT64 materialMask = ((UINT64(1) << materialBits) - 1) << materialShift;
+		static constexpr UINT64 pipelineStateMask = ((UINT64(1) << pipelineStateBits) - 1) << pipelineStateShift;
+		static constexpr UINT64 rootSignatureMask = ((UINT64(1) << rootSignatureBits) - 1) << rootSignatureShift;
+
+		static_assert(rootSignatureShift + rootSignatureBits == 64);
+
+		/// <summary>
+		/// Maps a depth in [0, 1] to the key's depth bits, so draws sharing state are ordered front to back.
+		/// Pass 1 - depth to order back to front instead
+		/// </summary>
+		static constexpr UINT32 QuantizeDepth(float depth) noexcept
+		{
+			return static_cast<UINT32>(std::clamp(depth, 0.f, 1.f) * static_cast<float>(depthMask));
+		}
+
+		constexpr UINT64 Pack() const noexcept
+		{
+			assert(rootSignature < (1u << rootSignatureBits));
+			assert(pipelineState < (1u << pipelineStateBits));
+			assert(material < (1u << materialBits));
+			assert(depth <= depthMask);
+			return (UINT64(rootSignature) << rootSignatureShift)
+				| (UINT64(pipelineState) << pipelineStateShift)
+				| (UINT64(material) << materialShift)
+				| UINT64(depth);
+		}
+
+		static constexpr DrawKeyFields Unpack(UINT64 key) noexcept
+		{
+			return
+			{
+				static_cast<UINT32>((key & rootSignatureMask) >> rootSignatureShift),
+				static_cast<UINT32>((key & pipelineStateMask) >> pipelineStateShift),
+				static_cast<UINT32>((key & materialMask) >> materialShift),
+				static_cast<UINT32>(key & depthMask)
+			};
+		}
+	};
+
+	export struct QueuedDraw
+	{
+		WrapperView<ID3D12RootSignature> rootSignature;
+		WrapperView<ID3D12PipelineState> pipelineState;
+
+		//Bound to the material root parameter whenever the key's material bits change
+		D3D12_GPU_DESCRIPTOR_HANDLE material{};
+
+		//Bound to the per draw constants root parameter whenever it differs from the previous draw's
+		D3D12_GPU_VIRTUAL_ADDRESS constants = 0;
+
+		D3D12_PRIMITIVE_TOPOLOGY topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		D3D12_VERTEX_BUFFER_VIEW vertexBuffer{};
+		D3D12_INDEX_BUFFER_VIEW indexBuffer{};
+		D3D12_DRAW_INDEXED_ARGUMENTS arguments{};
+	};
+
+	export struct DrawQueueBindings
+	{
+		std::optional<UINT> materialRootParameter;
+		std::optional<UINT> constantsRootParameter;
+	};
+
+	export struct DrawQueueStatistics
+	{
+		UINT draws = 0;
+		UINT rootSignatureChanges = 0;
+		UINT pipelineStateChanges = 0;
+		UINT materialChanges = 0;
+		UINT geometryChanges = 0;
+	};
+
+	/// <summary>
+	/// Collects indexed draws with 64 bit sort keys, radix sorts them and records them so that root signatures,
+	/// pipeline states and materials are only set when the corresponding key bits change.
+	/// Keys and draw indices are sorted as separate columns, the draws themselves are never moved.
+	/// Large queues split every radix pass across tasks run through ParallelFor.
+	/// State is identified by the key alone, draws with equal key fields must use the same objects
+	/// </summary>
+	export class DrawQueue
+	{
+		static constexpr UINT radixBits = 8;
+		static constexpr size_t bucketCount = size_t(1) << radixBits;
+		static constexpr UINT passCount = 64 / radixBits;
+
+		//Below this many draws per task, splitting a pass costs more than it saves
+		static constexpr size_t minimumDrawsPerTask = 16 * 1024;
+
+		std::vector<UINT64> keys;
+		std::vector<QueuedDraw> draws;
+
+		std::vector<UINT64> sortedKeys;
+		std::vector<UINT32> sortedOrder;
+		std::vector<UINT64> scratchKeys;
+		std::vector<UINT32> scratchOrder;
+		std::vector<std::array<UINT32, bucketCount>> histograms;
+		std::vector<UINT64> varyingBits;
+		bool sorted = true;
+
+		ParallelFor parallelFor;
+		size_t maxSortTasks;
+
+	public:
+		DrawQueue(ParallelFor parallelFor = nullptr, size_t maxSortTasks = std::max(std::thread::hardware_concurrency(), 1u)) :
+			parallelFor{ parallelFor ? std::move(parallelFor) : ParallelFor{ &RunOnThreads } },
+			maxSortTasks{ std::max<size_t>(maxSortTasks, 1) }
+		{
+		}
+
+	public:
+		void Push(UINT64 key, const QueuedDraw& draw)
+		{
+			assert(draws.size() < std::numeric_limits<UINT32>::max());
+			keys.push_back(key);
+			draws.push_back(draw);
+			sorted = false;
+		}
+
+		void Push(const DrawKeyFields& key, const QueuedDraw& draw)
+		{
+			Push(key.Pack(), draw);
+		}
+
+		/// <summary>
+		/// Stable LSD radix sort of the keys, 8 bits per pass. Passes over digits that are the same in every key are skipped.
+		/// Called by Record when needed, call it earlier to sort off the recording thread
+		/// </summary>
+		void Sort()
+		{
+			if(sorted)
+				return;
+
+			const size_t count = keys.size();
+			sortedKeys.assign(keys.begin(), keys.end());
+			sortedOrder.resize(count);
+			std::iota(sortedOrder.begin(), sortedOrder.end(), 0u);
+			scratchKeys.resize(count);
+			scratchOrder.resize(count);
+
+			const size_t taskCount = std::clamp<size_t>(count / minimumDrawsPerTask, 1, maxSortTasks);
+			const size_t chunkSize = (count + taskCount - 1) / taskCount;
+			auto chunk = [&](size_t task) { return std::pair{ std::min(task * chunkSize, count), std::min((task + 1) * chunkSize, count) }; };
+
+			varyingBits.assign(taskCount, 0);
+			RunTasks(taskCount, [&](size_t task)
+			{
+				auto [begin, end] = chunk(task);
+				UINT64 bits = 0;
+				for(size_t i = begin; i < end; i++)
+					bits |= keys[i] ^ keys[0];
+				varyingBits[task] = bits;
+			});
+			const UINT64 varying = std::reduce(varyingBits.begin(), varyingBits.end(), UINT64(0), std::bit_or<>{});
+
+			histograms.resize(taskCount);
+			for(UINT pass = 0; pass < passCount; pass++)
+			{
+				const UINT shift = pass * radixBits;
+				if(((varying >> shift) & (bucketCount - 1)) == 0)
+					continue;
+
+				RunTasks(taskCount, [&](size_t task)
+				{
+					auto [begin, end] = chunk(task);
+					std::array<UINT32, bucketCount>& histogram = histograms[task];
+					histogram.fill(0);
+					for(size_t i = begin; i < end; i++)
+						histogram[(sortedKeys[i] >> shift) & (bucketCount - 1)]++;
+				});
+
+				//Each task writes its part of every bucket after the parts of the tasks before it, which keeps the sort stable
+				UINT32 offset = 0;
+				for(size_t bucket = 0; bucket < bucketCount; bucket++)
+				{
+					for(std::array<UINT32, bucketCount>& histogram : histograms)
+						offset += std::exchange(histogram[bucket], offset);
+				}
+
+				RunTasks(taskCount, [&](size_t task)
+				{
+					auto [begin, end] = chunk(task);
+					std::array<UINT32, bucketCount>& offsets = histograms[task];
+					for(size_t i = begin; i < end; i++)
+					{
+						const UINT32 destination = offsets[(sortedKeys[i] >> shift) & (bucketCount - 1)]++;
+						scratchKeys[destination] = sortedKeys[i];
+						scratchOrder[destination] = sortedOrder[i];
+					}
+				});
+
+				sortedKeys.swap(scratchKeys);
+				sortedOrder.swap(scratchOrder);
+			}
+
+			sorted = true;
+		}
+
+		/// <summary>
+		/// Sorts the queue if needed and records every draw, only setting state that changed since the previous draw.
+		/// The queue is left intact so it can be recorded again
+		/// </summary>
+		template<class ListTy>
+		DrawQueueStatistics Record(ListTy& commandList, const DrawQueueBindings& bindings = {})
+		{
+			Sort();
+
+			DrawQueueStatistics statistics;
+			const QueuedDraw* previous = nullptr;
+			UINT64 previousKey = 0;
+			for(size_t i = 0; i < sortedKeys.size(); i++)
+			{
+				const UINT64 key = sortedKeys[i];
+				const QueuedDraw& draw = draws[sortedOrder[i]];
+				const UINT64 changedBits = previous ? key ^ previousKey : ~UINT64(0);
+
+				//Changing the root signature resets every root argument, so everything bound through it is set again
+				const bool rootSignatureChanged = changedBits & DrawKeyFields::rootSignatureMask;
+				if(rootSignatureChanged)
+				{
+					commandList->SetGraphicsRootSignature(draw.rootSignature);
+					statistics.rootSignatureChanges++;
+				}
+				assert(rootSignatureChanged || draw.rootSignature.Get() == previous->rootSignature.Get());
+
+				const bool pipelineStateChanged = rootSignatureChanged || (changedBits & DrawKeyFields::pipelineStateMask);
+				if(pipelineStateChanged)
+				{
+					commandList->SetPipelineState(draw.pipelineState);
+					statistics.pipelineStateChanges++;
+				}
+				assert(pipelineStateChanged || draw.pipelineState.Get() == previous->pipelineState.Get());
+
+				if(bindings.materialRootParameter && (rootSignatureChanged || (changedBits & DrawKeyFields::materialMask)))
+				{
+					commandList->SetGraphicsRootDescriptorTable(*bindings.materialRootParameter, draw.material);
+					statistics.materialChanges++;
+				}
+
+				if(bindings.constantsRootParameter && (rootSignatureChanged || draw.constants != previous->constants))
+					commandList->SetGraphicsRootConstantBufferView(*bindings.constantsRootParameter, draw.constants);
+
+				if(!previous || draw.topology != previous->topology)
+					commandList->IASetPrimitiveTopology(draw.topology);
+
+				const bool vertexBufferChanged = !previous || !SameView(draw.vertexBuffer, previous->vertexBuffer);
+				const bool indexBufferChanged = !previous || !SameView(draw.indexBuffer, previous->indexBuffer);
+				if(vertexBufferChanged)
+					commandList->IASetVertexBuffers(0, std::span(&draw.vertexBuffer, 1));
+				if(indexBufferChanged)
+					commandList->IASetIndexBuffer(&draw.indexBuffer);
+				if(vertexBufferChanged || indexBufferChanged)
+					statistics.geometryChanges++;
+
+				const D3D12_DRAW_INDEXED_ARGUMENTS& arguments = draw.arguments;
+				commandList->DrawIndexedInstanced(arguments.IndexCountPerInstance, arguments.InstanceCount, arguments.StartIndexLocation, arguments.BaseVertexLocation, arguments.StartInstanceLocation);
+				statistics.draws++;
+
+				previous = &draw;
+				previousKey = key;
+			}
+			return statistics;
+		}
+
+		/// <summary>
+		/// Empties the queue, keeping its memory for the next frame
+		/// </summary>
+		void Clear() noexcept
+		{
+			keys.clear();
+			draws.clear();
+			sortedKeys.clear();
+			sortedOrder.clear();
+			sorted = true;
+		}
+
+	public:
+		size_t Size() const noexcept { return draws.size(); }
+		bool Empty() const noexcept { return draws.empty(); }
+
+		//The keys in sorted order, only valid after Sort
+		std::span<const UINT64> GetSortedKeys() const noexcept { assert(sorted); return sortedKeys; }
+
+		//The index of the draw at every sorted position, in push order, only valid after Sort
+		std::span<const UINT32> GetSortedOrder() const noexcept { assert(sorted); return sortedOrder; }
+
+		std::span<const QueuedDraw> GetDraws() const noexcept { return draws; }
+
+	private:
+		template<class TaskFn>
+		void RunTasks(size_t taskCount, TaskFn&& task)
+		{
+			if(taskCount == 1)
+				task(0);
+			else
+				parallelFor(taskCount, std::function<void(size_t)>(std::ref(task)));
+		}
+
+		static bool SameView(const D3D12_VERTEX_BUFFER_VIEW& left, const D3D12_VERTEX_BUFFER_VIEW& right) noexcept
+		{
+			return left.BufferLocation == right.BufferLocation && left.SizeInBytes == right.SizeInBytes && left.StrideInBytes == right.StrideInBytes;
+		}
+
+		static bool SameView(const D3D12_INDEX_BUFFER_VIEW& left, const D3D12_INDEX_BUFFER_VIEW& right) noexcept
+		{
+			return left.BufferLocation == right.BufferLocation && left.SizeInBytes == right.SizeInBytes && left.Format == right.Format;
+		}
+	};
+}
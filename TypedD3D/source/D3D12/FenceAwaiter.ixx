@@ -0,0 +1,294 @@
+module;
+
+#include <d3d12.h>
+#include <algorithm>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <gsl/pointers>
+
+export module TypedD3D12:FenceAwaiter;
+import TypedD3D.Shared;
+import :Device;
+
+namespace TypedD3D::D3D12
+{
+	/// <summary>
+	/// Backend of BasicFenceAwaiterService which waits for real fences through SetEventOnMultipleFenceCompletion
+	/// </summary>
+	export class D3D12FenceWaitBackend
+	{
+	public:
+		using fence_type = ID3D12Fence*;
+
+	private:
+		Wrapper<ID3D12Device1> device;
+		HANDLE fenceEvent;
+		HANDLE wakeEvent;
+
+	public:
+		D3D12FenceWaitBackend(Wrapper<ID3D12Device1> device) :
+			device{ std::move(device) },
+			fenceEvent{ CreateEventW(nullptr, FALSE, FALSE, nullptr) },
+			wakeEvent{ CreateEventW(nullptr, FALSE, FALSE, nullptr) }
+		{
+			if(fenceEvent == nullptr || wakeEvent == nullptr)
+				ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+		}
+
+		D3D12FenceWaitBackend(const D3D12FenceWaitBackend&) = delete;
+		D3D12FenceWaitBackend& operator=(const D3D12FenceWaitBackend&) = delete;
+
+		~D3D12FenceWaitBackend()
+		{
+			if(fenceEvent)
+				CloseHandle(fenceEvent);
+			if(wakeEvent)
+				CloseHandle(wakeEvent);
+		}
+
+	public:
+		UINT64 GetCompletedValue(fence_type fence) { return fence->GetCompletedValue(); }
+
+		/// <summary>
+		/// Blocks until any of the fences reaches its value or Wake is called
+		/// </summary>
+		void WaitAny(std::span<const fence_type> fences, std::span<UINT64> values)
+		{
+			device->SetEventOnMultipleFenceCompletion({ static_cast<UINT>(fences.size()), fences.data(), values.data() }, D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY, fenceEvent);
+
+			const HANDLE events[] = { fenceEvent, wakeEvent };
+			if(WaitForMultipleObjects(2, events, FALSE, INFINITE) == WAIT_FAILED)
+				ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+		}
+
+		/// <summary>
+		/// Wakes the current or next WaitAny
+		/// </summary>
+		void Wake() { SetEvent(wakeEvent); }
+	};
+
+	/// <summary>
+	/// Resumes coroutines waiting on fence values from a single waiter thread.
+	/// The backend provides fence_type, GetCompletedValue(fence), WaitAny(fences, values) and Wake().
+	/// Wake must be sticky: a Wake made before WaitAny is entered has to make it return.
+	/// Coroutines are resumed through the executor, by default on the waiter thread itself.
+	/// If WaitAny throws, the waits it was blocking on are resumed and rethrow the exception from co_await.
+	/// Exceptions thrown by the executor or a resumed coroutine are kept for TakeFailure instead of ending the waiter thread.
+	/// Every awaiting coroutine must have been resumed before the service is destroyed
+	/// </summary>
+	export template<class Backend>
+	class BasicFenceAwaiterService
+	{
+	public:
+		using fence_type = typename Backend::fence_type;
+		using Executor = std::function<void(std::coroutine_handle<>)>;
+
+		class Awaiter
+		{
+			friend BasicFenceAwaiterService;
+
+			BasicFenceAwaiterService* service;
+			fence_type fence;
+			UINT64 value;
+			std::exception_ptr failure;
+
+		public:
+			Awaiter(BasicFenceAwaiterService& service, fence_type fence, UINT64 value) :
+				service{ &service },
+				fence{ fence },
+				value{ value }
+			{
+			}
+
+			bool await_ready() { return service->backend.GetCompletedValue(fence) >= value; }
+			void await_suspend(std::coroutine_handle<> handle) { service->Enqueue({ fence, value, handle, this }); }
+
+			void await_resume() const
+			{
+				if(failure)
+					std::rethrow_exception(failure);
+			}
+		};
+
+	private:
+		struct PendingWait
+		{
+			fence_type fence;
+			UINT64 value;
+			std::coroutine_handle<> handle;
+			Awaiter* awaiter;
+		};
+
+		Backend backend;
+		Executor executor;
+
+		std::mutex mutex;
+		std::condition_variable submitted;
+		std::vector<PendingWait> incoming;
+		std::vector<std::exception_ptr> failures;
+		bool stopping = false;
+
+		std::thread waiter;
+
+	public:
+		template<class... BackendArgs>
+		BasicFenceAwaiterService(Executor executor, BackendArgs&&... backendArgs) :
+			backend{ std::forward<BackendArgs>(backendArgs)... },
+			executor{ executor ? std::move(executor) : Executor{ [](std::coroutine_handle<> handle) { handle.resume(); } } }
+		{
+			waiter = std::thread([this] { WaiterLoop(); });
+		}
+
+		BasicFenceAwaiterService(const BasicFenceAwaiterService&) = delete;
+		BasicFenceAwaiterService& operator=(const BasicFenceAwaiterService&) = delete;
+
+		~BasicFenceAwaiterService()
+		{
+			{
+				std::scoped_lock lock{ mutex };
+				stopping = true;
+			}
+			submitted.notify_one();
+			backend.Wake();
+			waiter.join();
+		}
+
+	public:
+		/// <summary>
+		/// co_await service.Wait(fence, value) suspends until the fence reaches the value
+		/// </summary>
+		Awaiter Wait(fence_type fence, UINT64 value) { return Awaiter{ *this, fence, value }; }
+
+		Backend& GetBackend() noexcept { return backend; }
+
+		/// <summary>
+		/// Returns the oldest exception thrown by the executor or a resumed coroutine and forgets it, or null if there is none
+		/// </summary>
+		std::exception_ptr TakeFailure()
+		{
+			std::scoped_lock lock{ mutex };
+			if(failures.empty())
+				return nullptr;
+
+			std::exception_ptr failure = std::move(failures.front());
+			failures.erase(failures.begin());
+			return failure;
+		}
+
+	private:
+		void Enqueue(PendingWait wait)
+		{
+			{
+				std::scoped_lock lock{ mutex };
+				incoming.push_back(wait);
+			}
+			submitted.notify_one();
+			backend.Wake();
+		}
+
+		void WaiterLoop()
+		{
+			std::vector<PendingWait> pending;
+			std::vector<PendingWait> completed;
+			std::vector<fence_type> fences;
+			std::vector<UINT64> values;
+
+			while(true)
+			{
+				{
+					std::unique_lock lock{ mutex };
+					submitted.wait(lock, [&] { return stopping || !incoming.empty() || !pending.empty(); });
+					if(stopping)
+						return;
+
+					pending.insert(pending.end(), incoming.begin(), incoming.end());
+					incoming.clear();
+				}
+
+				auto firstCompleted = std::partition(pending.begin(), pending.end(), [&](const PendingWait& wait) { return backend.GetCompletedValue(wait.fence) < wait.value; });
+				completed.assign(firstCompleted, pending.end());
+				pending.erase(firstCompleted, pending.end());
+
+				for(const PendingWait& wait : completed)
+					Resume(wait.handle);
+
+				if(!completed.empty() || pending.empty())
+					continue;
+
+				//Only the lowest value of every fence matters to wake up
+				fences.clear();
+				values.clear();
+				for(const PendingWait& wait : pending)
+				{
+					auto it = std::ranges::find(fences, wait.fence);
+					if(it == fences.end())
+					{
+						fences.push_back(wait.fence);
+						values.push_back(wait.value);
+					}
+					else
+					{
+						UINT64& value = values[it - fences.begin()];
+						value = std::min(value, wait.value);
+					}
+				}
+
+				try
+				{
+					backend.WaitAny(fences, values);
+				}
+				catch(...)
+				{
+					//The waits can't complete anymore, so they are resumed with the exception instead
+					const std::exception_ptr failure = std::current_exception();
+					for(const PendingWait& wait : pending)
+					{
+						wait.awaiter->failure = failure;
+						Resume(wait.handle);
+					}
+					pending.clear();
+				}
+			}
+		}
+
+		//Nothing can catch an exception leaving the waiter thread, so they are kept for TakeFailure
+		void Resume(std::coroutine_handle<> handle)
+		{
+			try
+			{
+				executor(handle);
+			}
+			catch(...)
+			{
+				std::scoped_lock lock{ mutex };
+				failures.push_back(std::current_exception());
+			}
+		}
+	};
+
+	/// <summary>
+	/// Lets coroutines co_await fence completion without parking a thread each
+	/// </summary>
+	export class FenceAwaiterService : public BasicFenceAwaiterService<D3D12FenceWaitBackend>
+	{
+		using Base = BasicFenceAwaiterService<D3D12FenceWaitBackend>;
+
+	public:
+		FenceAwaiterService(Wrapper<ID3D12Device1> device, Executor executor = nullptr) :
+			Base{ std::move(executor), std::move(device) }
+		{
+		}
+
+	public:
+		using Base::Wait;
+
+		Awaiter Wait(gsl::not_null<WrapperView<ID3D12Fence>> fence, UINT64 value) { return Base::Wait(fence.get().Get(), value); }
+	};
+}
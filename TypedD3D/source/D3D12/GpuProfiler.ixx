@@ -0,0 +1,367 @@
+module;
+
+#include <d3d12.h>
+#include <cassert>
+#include <climits>
+#include <format>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <gsl/pointers>
+
+export module TypedD3D12:GpuProfiler;
+import TypedD3D.Shared;
+import :Device;
+import :Resource;
+import :CommandQueue;
+
+namespace TypedD3D::D3D12
+{
+	/// <summary>
+	/// A profiled GPU scope, begin is in microseconds of the CPU's QueryPerformanceCounter clock
+	/// </summary>
+	export struct GpuTiming
+	{
+		std::string name;
+		UINT depth;
+		UINT64 frame;
+		double beginMicroseconds;
+		double durationMicroseconds;
+	};
+
+	void AppendJsonString(std::string& out, std::string_view string)
+	{
+		out += '"';
+		for(char c : string)
+		{
+			switch(c)
+			{
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if(static_cast<unsigned char>(c) < 0x20)
+					out += std::format("\\u{:04x}", static_cast<unsigned>(c));
+				else
+					out += c;
+			}
+		}
+		out += '"';
+	}
+
+	/// <summary>
+	/// Formats timings as Chrome trace event JSON, which chrome://tracing and Perfetto open.
+	/// Nested scopes show up nested as their time ranges contain each other
+	/// </summary>
+	export std::string WriteChromeTrace(std::span<const GpuTiming> timings, std::string_view trackName = "GPU")
+	{
+		std::string out = "{\"traceEvents\":[";
+		for(size_t i = 0; i < timings.size(); i++)
+		{
+			const GpuTiming& timing = timings[i];
+			if(i > 0)
+				out += ',';
+
+			out += "{\"name\":";
+			AppendJsonString(out, timing.name);
+			out += ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+			AppendJsonString(out, trackName);
+			out += std::format(",\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"frame\":{},\"depth\":{}}}}}", timing.beginMicroseconds, timing.durationMicroseconds, timing.frame, timing.depth);
+		}
+		out += "],\"displayTimeUnit\":\"ms\"}";
+		return out;
+	}
+
+	/// <summary>
+	/// Hands out a frame's timestamp queries to nested scopes.
+	/// A scope only begins when there are queries left for its own end and the ends of every scope still open around it
+	/// </summary>
+	export class TimestampQueryBudget
+	{
+		UINT capacity = 0;
+		UINT usedCount = 0;
+		UINT reservedEnds = 0;
+
+	public:
+		TimestampQueryBudget() = default;
+		TimestampQueryBudget(UINT capacity) :
+			capacity{ capacity }
+		{
+		}
+
+	public:
+		void Reset() noexcept
+		{
+			usedCount = 0;
+			reservedEnds = 0;
+		}
+
+		/// <summary>
+		/// Returns the scope's begin query, or UINT_MAX if the scope doesn't fit. Only scopes that got a query are ended
+		/// </summary>
+		UINT BeginScope() noexcept
+		{
+			if(usedCount + 2 + reservedEnds > capacity)
+				return UINT_MAX;
+
+			reservedEnds++;
+			return usedCount++;
+		}
+
+		UINT EndScope() noexcept
+		{
+			assert(reservedEnds > 0);
+			reservedEnds--;
+			return usedCount++;
+		}
+
+		UINT GetUsedCount() const noexcept { return usedCount; }
+	};
+
+	/// <summary>
+	/// Measures nested GPU scopes with timestamp queries resolved into a readback ring of framesInFlight frames.
+	/// Results are read once the GPU is done with a frame and never waited on, if the oldest frame is still in flight when a new one begins, that new frame isn't profiled.
+	/// GPU timestamps are aligned to the CPU clock through GetClockCalibration.
+	/// Timestamp queries aren't supported on copy queues
+	/// </summary>
+	export class GpuProfiler
+	{
+		struct Scope
+		{
+			std::string name;
+			UINT depth;
+			UINT beginQuery;
+			UINT endQuery = UINT_MAX;
+		};
+
+		struct FrameRecord
+		{
+			std::vector<Scope> scopes;
+			UINT64 fenceValue = 0;
+			UINT64 frame = 0;
+			ClockCalibrationData calibration{};
+			bool pending = false;
+		};
+
+		Wrapper<ID3D12QueryHeap> queryHeap;
+		Wrapper<ID3D12Resource> readback;
+		const UINT64* readbackData = nullptr;
+		Wrapper<ID3D12Fence> fence;
+		UINT64 fenceValue = 0;
+
+		UINT maxQueriesPerFrame;
+		std::vector<FrameRecord> frames;
+		UINT currentFrame = 0;
+		UINT64 frameCount = 0;
+		bool profiling = false;
+		std::vector<UINT> openScopes;
+		TimestampQueryBudget queries;
+
+		UINT64 gpuFrequency = 0;
+		LARGE_INTEGER cpuFrequency{};
+
+		std::vector<GpuTiming> timings;
+		UINT64 droppedFrames = 0;
+
+	public:
+		GpuProfiler(gsl::not_null<WrapperView<ID3D12Device>> device, UINT maxScopesPerFrame = 512, UINT framesInFlight = 3) :
+			maxQueriesPerFrame{ maxScopesPerFrame * 2 },
+			queries{ maxQueriesPerFrame },
+			frames(framesInFlight)
+		{
+			const UINT queryCount = maxQueriesPerFrame * framesInFlight;
+			queryHeap = device->CreateQueryHeap({ .Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP, .Count = queryCount });
+
+			D3D12_RESOURCE_DESC desc
+			{
+				.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+				.Width = UINT64(queryCount) * sizeof(UINT64),
+				.Height = 1,
+				.DepthOrArraySize = 1,
+				.MipLevels = 1,
+				.SampleDesc = { 1, 0 },
+				.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR
+			};
+			readback = device->CreateCommittedResource({ .Type = D3D12_HEAP_TYPE_READBACK }, D3D12_HEAP_FLAG_NONE, desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr);
+			readbackData = reinterpret_cast<const UINT64*>(readback->Map(0, nullptr));
+			fence = device->CreateFence(0, D3D12_FENCE_FLAG_NONE);
+			QueryPerformanceFrequency(&cpuFrequency);
+		}
+
+		GpuProfiler(const GpuProfiler&) = delete;
+		GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+	public:
+		/// <summary>
+		/// Collects the results of finished frames and starts recording scopes for a new frame
+		/// </summary>
+		template<class QueueTy>
+		void BeginFrame(QueueTy& queue)
+		{
+			assert(!profiling);
+			CollectCompletedFrames();
+
+			if(gpuFrequency == 0)
+				gpuFrequency = queue->GetTimestampFrequency();
+
+			FrameRecord& frame = frames[currentFrame];
+			frameCount++;
+			if(frame.pending)
+			{
+				droppedFrames++;
+				return;
+			}
+
+			frame.scopes.clear();
+			frame.frame = frameCount;
+			frame.calibration = queue->GetClockCalibration();
+			openScopes.clear();
+			queries.Reset();
+			profiling = true;
+		}
+
+		template<class CommandListTy>
+		void BeginScope(CommandListTy& commandList, std::string_view name)
+		{
+			if(!profiling)
+				return;
+
+			const UINT query = queries.BeginScope();
+			if(query == UINT_MAX)
+			{
+				openScopes.push_back(UINT_MAX);
+				return;
+			}
+
+			FrameRecord& frame = frames[currentFrame];
+			openScopes.push_back(static_cast<UINT>(frame.scopes.size()));
+			frame.scopes.push_back({ std::string(name), static_cast<UINT>(openScopes.size() - 1), FrameQuery(query) });
+			commandList->EndQuery(queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, frame.scopes.back().beginQuery);
+		}
+
+		template<class CommandListTy>
+		void EndScope(CommandListTy& commandList)
+		{
+			if(!profiling)
+				return;
+
+			assert(!openScopes.empty());
+			const UINT scope = openScopes.back();
+			openScopes.pop_back();
+			if(scope == UINT_MAX)
+				return;
+
+			FrameRecord& frame = frames[currentFrame];
+			frame.scopes[scope].endQuery = FrameQuery(queries.EndScope());
+			commandList->EndQuery(queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, frame.scopes[scope].endQuery);
+		}
+
+		/// <summary>
+		/// Resolves the frame's queries, commandList must be executed after every list containing scopes of the frame
+		/// </summary>
+		template<class CommandListTy>
+		void EndFrame(CommandListTy& commandList)
+		{
+			if(!profiling)
+				return;
+
+			assert(openScopes.empty());
+			if(const UINT queryCount = queries.GetUsedCount(); queryCount > 0)
+			{
+				const UINT firstQuery = currentFrame * maxQueriesPerFrame;
+				commandList->ResolveQueryData(queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, firstQuery, queryCount, readback, UINT64(firstQuery) * sizeof(UINT64));
+			}
+		}
+
+		/// <summary>
+		/// Call once the list passed to EndFrame has been executed on the queue
+		/// </summary>
+		template<class QueueTy>
+		void Submitted(QueueTy& queue)
+		{
+			if(profiling)
+			{
+				FrameRecord& frame = frames[currentFrame];
+				frame.fenceValue = ++fenceValue;
+				frame.pending = true;
+				ThrowIfFailed(queue->Signal(fence, fenceValue));
+				profiling = false;
+			}
+
+			currentFrame = (currentFrame + 1) % static_cast<UINT>(frames.size());
+		}
+
+		/// <summary>
+		/// Returns every timing collected since the last call
+		/// </summary>
+		std::vector<GpuTiming> ConsumeTimings() { return std::exchange(timings, {}); }
+
+		UINT64 GetDroppedFrameCount() const noexcept { return droppedFrames; }
+
+	private:
+		UINT FrameQuery(UINT query) const
+		{
+			return currentFrame * maxQueriesPerFrame + query;
+		}
+
+		void CollectCompletedFrames()
+		{
+			//Starting at the current slot visits frames from oldest to newest
+			const UINT64 completed = fence->GetCompletedValue();
+			for(size_t i = 0; i < frames.size(); i++)
+			{
+				FrameRecord& frame = frames[(currentFrame + i) % frames.size()];
+				if(!frame.pending || frame.fenceValue > completed)
+					continue;
+
+				frame.pending = false;
+				const double gpuToMicroseconds = 1'000'000.0 / static_cast<double>(gpuFrequency);
+				const double calibrationMicroseconds = static_cast<double>(frame.calibration.cpuTimestamp) * 1'000'000.0 / static_cast<double>(cpuFrequency.QuadPart);
+
+				for(const Scope& scope : frame.scopes)
+				{
+					if(scope.endQuery == UINT_MAX)
+						continue;
+
+					const UINT64 begin = readbackData[scope.beginQuery];
+					const UINT64 end = readbackData[scope.endQuery];
+					const double beginOffset = (static_cast<double>(begin) - static_cast<double>(frame.calibration.gpuTimestamp)) * gpuToMicroseconds;
+					timings.push_back(
+						{
+							.name = scope.name,
+							.depth = scope.depth,
+							.frame = frame.frame,
+							.beginMicroseconds = calibrationMicroseconds + beginOffset,
+							.durationMicroseconds = end >= begin ? static_cast<double>(end - begin) * gpuToMicroseconds : 0.0
+						});
+				}
+			}
+		}
+	};
+
+	/// <summary>
+	/// Profiles the GPU work recorded into the command list for as long as it lives
+	/// </summary>
+	export template<class CommandListTy>
+	class GpuScope
+	{
+		GpuProfiler& profiler;
+		CommandListTy& commandList;
+
+	public:
+		GpuScope(GpuProfiler& profiler, CommandListTy& commandList, std::string_view name) :
+			profiler{ profiler },
+			commandList{ commandList }
+		{
+			profiler.BeginScope(commandList, name);
+		}
+
+		GpuScope(const GpuScope&) = delete;
+		GpuScope& operator=(const GpuScope&) = delete;
+
+		~GpuScope() { profiler.EndScope(commandList); }
+	};
+}
@@ -0,0 +1,322 @@
+module;
+
+#include <d3d12.h>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+export module TypedD3D12:IndirectBatcher;
+import TypedD3D.Shared;
+import :Device;
+import :Wrappers;
+import :DrawQueue;
+import :UploadRingAllocator;
+
+namespace TypedD3D::D3D12
+{
+	/// <summary>
+	/// Which root parameters the batched draws use. The material table must be the same for every draw of a batch,
+	/// the constant buffer view and root constants are per draw and are written into the argument buffer
+	/// </summary>
+	export struct IndirectBatchLayout
+	{
+		std::optional<UINT> materialRootParameter;
+		std::optional<UINT> constantsRootParameter;
+		std::optional<UINT> rootConstantsParameter;
+		UINT rootConstantCount = 0;
+
+		//Size of one command in the argument buffer: root constants, then the constant buffer address, then the draw arguments
+		UINT ByteStride() const noexcept
+		{
+			return static_cast<UINT>((rootConstantsParameter ? rootConstantCount * sizeof(UINT32) : 0)
+				+ (constantsRootParameter ? sizeof(D3D12_GPU_VIRTUAL_ADDRESS) : 0)
+				+ sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+		}
+
+		//Whether the command signature changes root arguments, in which case it is tied to a root signature
+		bool HasRootArguments() const noexcept
+		{
+			return rootConstantsParameter || constantsRootParameter;
+		}
+
+		std::vector<D3D12_INDIRECT_ARGUMENT_DESC> MakeArgumentDescs() const
+		{
+			std::vector<D3D12_INDIRECT_ARGUMENT_DESC> descs;
+			if(rootConstantsParameter)
+			{
+				D3D12_INDIRECT_ARGUMENT_DESC& desc = descs.emplace_back(D3D12_INDIRECT_ARGUMENT_DESC{ .Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT });
+				desc.Constant = { *rootConstantsParameter, 0, rootConstantCount };
+			}
+
+			if(constantsRootParameter)
+			{
+				D3D12_INDIRECT_ARGUMENT_DESC& desc = descs.emplace_back(D3D12_INDIRECT_ARGUMENT_DESC{ .Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW });
+				desc.ConstantBufferView = { *constantsRootParameter };
+			}
+
+			//The draw has to be the last argument
+			descs.push_back({ .Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED });
+			return descs;
+		}
+	};
+
+	export struct DrawRun
+	{
+		UINT first = 0;
+		UINT count = 0;
+
+		//Whether the run is submitted with one ExecuteIndirect, or as individual draws because it is too short to be worth it
+		bool indirect = false;
+	};
+
+	bool SameInputAssembly(const QueuedDraw& left, const QueuedDraw& right) noexcept
+	{
+		return left.topology == right.topology
+			&& left.vertexBuffer.BufferLocation == right.vertexBuffer.BufferLocation
+			&& left.vertexBuffer.SizeInBytes == right.vertexBuffer.SizeInBytes
+			&& left.vertexBuffer.StrideInBytes == right.vertexBuffer.StrideInBytes
+			&& left.indexBuffer.BufferLocation == right.indexBuffer.BufferLocation
+			&& left.indexBuffer.SizeInBytes == right.indexBuffer.SizeInBytes
+			&& left.indexBuffer.Format == right.indexBuffer.Format;
+	}
+
+	/// <summary>
+	/// Whether 2 draws can be part of the same ExecuteIndirect. The command signature only changes the per draw arguments,
+	/// so everything else bound for the draws has to match
+	/// </summary>
+	export bool CanShareIndirectBatch(const QueuedDraw& left, const QueuedDraw& right, const IndirectBatchLayout& layout) noexcept
+	{
+		return left.rootSignature.Get() == right.rootSignature.Get()
+			&& left.pipelineState.Get() == right.pipelineState.Get()
+			&& (!layout.materialRootParameter || left.material.ptr == right.material.ptr)
+			&& SameInputAssembly(left, right);
+	}
+
+	/// <summary>
+	/// Splits draws into runs of consecutive draws that can share an ExecuteIndirect.
+	/// Runs of at least minimumBatchSize draws are marked indirect, shorter runs are cheaper to draw directly
+	/// </summary>
+	export std::vector<DrawRun> PlanIndirectBatches(std::span<const QueuedDraw> draws, const IndirectBatchLayout& layout, UINT minimumBatchSize)
+	{
+		std::vector<DrawRun> runs;
+		for(UINT i = 0; i < draws.size();)
+		{
+			UINT end = i + 1;
+			while(end < draws.size() && CanShareIndirectBatch(draws[i], draws[end], layout))
+				end++;
+
+			runs.push_back({ i, end - i, end - i >= minimumBatchSize });
+			i = end;
+		}
+		return runs;
+	}
+
+	/// <summary>
+	/// Writes one command of the argument buffer, laid out as described by layout.MakeArgumentDescs
+	/// </summary>
+	export std::byte* WriteIndirectArguments(std::byte* destination, const IndirectBatchLayout& layout, const QueuedDraw& draw, std::span<const UINT32> rootConstants) noexcept
+	{
+		if(layout.rootConstantsParameter)
+		{
+			assert(rootConstants.size() == layout.rootConstantCount);
+			std::memcpy(destination, rootConstants.data(), rootConstants.size_bytes());
+			destination += rootConstants.size_bytes();
+		}
+
+		if(layout.constantsRootParameter)
+		{
+			std::memcpy(destination, &draw.constants, sizeof(draw.constants));
+			destination += sizeof(draw.constants);
+		}
+
+		std::memcpy(destination, &draw.arguments, sizeof(draw.arguments));
+		return destination + sizeof(draw.arguments);
+	}
+
+	export struct IndirectBatchStatistics
+	{
+		UINT draws = 0;
+		UINT indirectBatches = 0;
+		UINT indirectDraws = 0;
+		UINT directDraws = 0;
+	};
+
+	/// <summary>
+	/// Replaces runs of draws sharing a root signature, pipeline state and input assembly with single ExecuteIndirect calls.
+	/// Each run's draw arguments and per draw root arguments are written to an upload heap argument buffer,
+	/// and executed with a command signature generated from the layout, one per root signature.
+	/// Draws are recorded in the order they were pushed, push them sorted to get long runs
+	/// </summary>
+	export class IndirectBatcher
+	{
+	public:
+		static constexpr UINT defaultMinimumBatchSize = 4;
+
+	private:
+		struct CommandSignature
+		{
+			//Kept alive so that the key can't be reused by another root signature
+			Wrapper<ID3D12RootSignature> rootSignature;
+			Wrapper<ID3D12CommandSignature> commandSignature;
+		};
+
+		Wrapper<ID3D12Device> device;
+		IndirectBatchLayout layout;
+		UINT minimumBatchSize;
+
+		std::vector<QueuedDraw> draws;
+		std::vector<UINT32> rootConstants;
+		std::unordered_map<ID3D12RootSignature*, CommandSignature> commandSignatures;
+
+	public:
+		IndirectBatcher(Wrapper<ID3D12Device> device, const IndirectBatchLayout& layout, UINT minimumBatchSize = defaultMinimumBatchSize) :
+			device{ std::move(device) },
+			layout{ layout },
+			minimumBatchSize{ std::max(minimumBatchSize, 1u) }
+		{
+		}
+
+	public:
+		void Push(const QueuedDraw& draw, std::span<const UINT32> drawRootConstants = {})
+		{
+			assert(drawRootConstants.size() == (layout.rootConstantsParameter ? layout.rootConstantCount : 0));
+			draws.push_back(draw);
+			rootConstants.insert(rootConstants.end(), drawRootConstants.begin(), drawRootConstants.end());
+		}
+
+		/// <summary>
+		/// Pushes every draw of a draw queue in sorted order. Only usable when the layout has no root constants
+		/// </summary>
+		void Push(DrawQueue& queue)
+		{
+			assert(!layout.rootConstantsParameter);
+			queue.Sort();
+			std::span<const QueuedDraw> queuedDraws = queue.GetDraws();
+			for(UINT32 index : queue.GetSortedOrder())
+				draws.push_back(queuedDraws[index]);
+		}
+
+		/// <summary>
+		/// Records every pushed draw, allocating argument buffers from uploadAllocator, then empties the batcher.
+		/// The argument buffers must stay alive until the GPU is done with the command list
+		/// </summary>
+		template<class ListTy, class AllocatorTy>
+		IndirectBatchStatistics Record(ListTy& commandList, AllocatorTy& uploadAllocator)
+		{
+			IndirectBatchStatistics statistics;
+			const UINT stride = layout.ByteStride();
+			const QueuedDraw* previous = nullptr;
+			for(const DrawRun& run : PlanIndirectBatches(draws, layout, minimumBatchSize))
+			{
+				const QueuedDraw& draw = draws[run.first];
+				SetState(commandList, draw, previous);
+
+				if(run.indirect)
+				{
+					UploadAllocation arguments = uploadAllocator.Allocate(UINT64(stride) * run.count, sizeof(UINT32));
+					std::byte* destination = arguments.cpuAddress;
+					for(UINT i = run.first; i < run.first + run.count; i++)
+						destination = WriteIndirectArguments(destination, layout, draws[i], GetRootConstants(i));
+
+					commandList->ExecuteIndirect(
+						WrapperView<ID3D12CommandSignature>(GetCommandSignature(draw.rootSignature)),
+						run.count,
+						arguments.resource,
+						arguments.offset);
+
+					statistics.indirectBatches++;
+					statistics.indirectDraws += run.count;
+				}
+				else
+				{
+					for(UINT i = run.first; i < run.first + run.count; i++)
+					{
+						if(layout.rootConstantsParameter)
+							commandList->SetGraphicsRoot32BitConstants(*layout.rootConstantsParameter, layout.rootConstantCount, GetRootConstants(i).data(), 0);
+						if(layout.constantsRootParameter)
+							commandList->SetGraphicsRootConstantBufferView(*layout.constantsRootParameter, draws[i].constants);
+
+						const D3D12_DRAW_INDEXED_ARGUMENTS& drawArguments = draws[i].arguments;
+						commandList->DrawIndexedInstanced(drawArguments.IndexCountPerInstance, drawArguments.InstanceCount, drawArguments.StartIndexLocation, drawArguments.BaseVertexLocation, drawArguments.StartInstanceLocation);
+					}
+					statistics.directDraws += run.count;
+				}
+
+				statistics.draws += run.count;
+				previous = &draws[run.first + run.count - 1];
+			}
+
+			Clear();
+			return statistics;
+		}
+
+		void Clear() noexcept
+		{
+			draws.clear();
+			rootConstants.clear();
+		}
+
+	public:
+		const IndirectBatchLayout& GetLayout() const noexcept { return layout; }
+		std::span<const QueuedDraw> GetDraws() const noexcept { return draws; }
+
+		/// <summary>
+		/// Gets or creates the command signature used for draws with the given root signature
+		/// </summary>
+		Wrapper<ID3D12CommandSignature>& GetCommandSignature(WrapperView<ID3D12RootSignature> rootSignature)
+		{
+			//Without root arguments the command signature doesn't depend on the root signature and is shared
+			ID3D12RootSignature* key = layout.HasRootArguments() ? rootSignature.Get() : nullptr;
+			if(auto it = commandSignatures.find(key); it != commandSignatures.end())
+				return it->second.commandSignature;
+
+			const std::vector<D3D12_INDIRECT_ARGUMENT_DESC> argumentDescs = layout.MakeArgumentDescs();
+			const D3D12_COMMAND_SIGNATURE_DESC desc
+			{
+				.ByteStride = layout.ByteStride(),
+				.NumArgumentDescs = static_cast<UINT>(argumentDescs.size()),
+				.pArgumentDescs = argumentDescs.data()
+			};
+
+			//Created before inserting so that a failed creation doesn't leave a null signature cached
+			Wrapper<ID3D12CommandSignature> commandSignature = device->CreateCommandSignature(desc, key);
+			return commandSignatures.emplace(key, CommandSignature{ Wrapper<ID3D12RootSignature>(key), std::move(commandSignature) }).first->second.commandSignature;
+		}
+
+	private:
+		std::span<const UINT32> GetRootConstants(UINT drawIndex) const noexcept
+		{
+			if(!layout.rootConstantsParameter)
+				return {};
+
+			return std::span(rootConstants).subspan(size_t(drawIndex) * layout.rootConstantCount, layout.rootConstantCount);
+		}
+
+		template<class ListTy>
+		void SetState(ListTy& commandList, const QueuedDraw& draw, const QueuedDraw* previous)
+		{
+			const bool rootSignatureChanged = !previous || draw.rootSignature.Get() != previous->rootSignature.Get();
+			if(rootSignatureChanged)
+				commandList->SetGraphicsRootSignature(draw.rootSignature);
+
+			if(!previous || draw.pipelineState.Get() != previous->pipelineState.Get())
+				commandList->SetPipelineState(draw.pipelineState);
+
+			if(layout.materialRootParameter && (rootSignatureChanged || draw.material.ptr != previous->material.ptr))
+				commandList->SetGraphicsRootDescriptorTable(*layout.materialRootParameter, draw.material);
+
+			if(!previous || !SameInputAssembly(draw, *previous))
+			{
+				commandList->IASetPrimitiveTopology(draw.topology);
+				commandList->IASetVertexBuffers(0, std::span(&draw.vertexBuffer, 1));
+				commandList->IASetIndexBuffer(&draw.indexBuffer);
+			}
+		}
+	};
+}
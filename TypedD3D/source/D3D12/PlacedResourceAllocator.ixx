@@ -0,0 +1,237 @@
+module;
+
+#include <d3d12.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include <gsl/pointers>
+
+export module TypedD3D12:PlacedResourceAllocator;
+import TypedD3D.Shared;
+import :Device;
+import :Resource;
+import :TLSFAllocator;
+import :ResourceAllocationInfoCache;
+
+namespace TypedD3D::D3D12
+{
+	/// <summary>
+	/// Resource heap tier 1 hardware can't mix buffers, render target/depth stencil textures and other textures in one heap.
+	/// Tier 2 puts everything in the Universal category
+	/// </summary>
+	export enum class HeapCategory : UINT
+	{
+		Universal,
+		Buffers,
+		NonRenderTargetTextures,
+		RenderTargetTextures,
+		Count
+	};
+
+	export constexpr HeapCategory GetHeapCategory(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_HEAP_TIER tier) noexcept
+	{
+		if(tier != D3D12_RESOURCE_HEAP_TIER_1)
+			return HeapCategory::Universal;
+
+		if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+			return HeapCategory::Buffers;
+
+		if(desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+			return HeapCategory::RenderTargetTextures;
+
+		return HeapCategory::NonRenderTargetTextures;
+	}
+
+	export constexpr D3D12_HEAP_FLAGS GetHeapCategoryFlags(HeapCategory category) noexcept
+	{
+		switch(category)
+		{
+		case HeapCategory::Buffers: return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+		case HeapCategory::NonRenderTargetTextures: return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+		case HeapCategory::RenderTargetTextures: return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+		default: return D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+		}
+	}
+
+	export struct HeapAllocation
+	{
+		HeapCategory category = HeapCategory::Universal;
+		UINT32 heapIndex = 0;
+		TLSFAllocator::Allocation range;
+
+		UINT64 GetOffset() const noexcept { return range.offset; }
+		UINT64 GetSize() const noexcept { return range.size; }
+		bool IsValid() const noexcept { return range.IsValid(); }
+	};
+
+	/// <summary>
+	/// The CPU side bookkeeping of PlacedResourceAllocator.
+	/// Sub-allocates D3D12_RESOURCE_ALLOCATION_INFOs out of heaps of each category, adding a heap whenever none of the existing ones can fit the request.
+	/// Does not talk to the device, which makes it usable with made up allocation info
+	/// </summary>
+	export class HeapSuballocator
+	{
+	public:
+		static constexpr UINT64 defaultHeapSize = 64 * 1024 * 1024;
+
+	private:
+		UINT64 heapSize = defaultHeapSize;
+		std::array<std::vector<TLSFAllocator>, static_cast<size_t>(HeapCategory::Count)> heaps;
+
+	public:
+		HeapSuballocator(UINT64 heapSize = defaultHeapSize) :
+			heapSize{ heapSize }
+		{
+		}
+
+	public:
+		/// <summary>
+		/// heapIndex of the result may be equal to the previous heap count of the category, meaning a new heap has to be created to back it
+		/// </summary>
+		HeapAllocation Allocate(const D3D12_RESOURCE_ALLOCATION_INFO& info, HeapCategory category)
+		{
+			std::vector<TLSFAllocator>& categoryHeaps = heaps[static_cast<size_t>(category)];
+			for(UINT32 i = 0; i < categoryHeaps.size(); i++)
+			{
+				if(std::optional<TLSFAllocator::Allocation> range = categoryHeaps[i].Allocate(info.SizeInBytes, info.Alignment))
+					return { category, i, *range };
+			}
+
+			TLSFAllocator& heap = categoryHeaps.emplace_back(std::max(heapSize, AlignUp(info.SizeInBytes, D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT)));
+			std::optional<TLSFAllocator::Allocation> range = heap.Allocate(info.SizeInBytes, info.Alignment);
+			if(!range)
+			{
+				categoryHeaps.pop_back();
+				throw std::invalid_argument("Resource does not fit in a new heap");
+			}
+			return { category, static_cast<UINT32>(categoryHeaps.size() - 1), *range };
+		}
+
+		void Free(const HeapAllocation& allocation)
+		{
+			heaps[static_cast<size_t>(allocation.category)][allocation.heapIndex].Free(allocation.range);
+		}
+
+		/// <summary>
+		/// Forgets the most recently added heap of the category, used when its backing heap failed to be created
+		/// </summary>
+		void PopHeap(HeapCategory category)
+		{
+			assert(heaps[static_cast<size_t>(category)].back().IsEmpty());
+			heaps[static_cast<size_t>(category)].pop_back();
+		}
+
+	public:
+		UINT64 GetDefaultHeapSize() const noexcept { return heapSize; }
+		UINT32 GetHeapCount(HeapCategory category) const noexcept { return static_cast<UINT32>(heaps[static_cast<size_t>(category)].size()); }
+		const TLSFAllocator& GetHeap(HeapCategory category, UINT32 heapIndex) const { return heaps[static_cast<size_t>(category)][heapIndex]; }
+	};
+
+	export struct PlacedResource
+	{
+		Wrapper<ID3D12Resource> resource;
+		HeapAllocation allocation;
+	};
+
+	/// <summary>
+	/// Places resources into large heaps created through CreateHeap instead of giving every resource its own committed heap.
+	/// The resource must be released and no longer used by the GPU before its allocation is Freed.
+	/// Thread safe
+	/// </summary>
+	export class PlacedResourceAllocator
+	{
+		Wrapper<ID3D12Device> device;
+		D3D12_HEAP_PROPERTIES heapProperties;
+		D3D12_RESOURCE_HEAP_TIER heapTier;
+		ResourceAllocationInfoCache allocationInfoCache;
+
+		std::mutex mutex;
+		HeapSuballocator suballocator;
+		std::array<std::vector<Wrapper<ID3D12Heap>>, static_cast<size_t>(HeapCategory::Count)> heaps;
+
+	public:
+		PlacedResourceAllocator(Wrapper<ID3D12Device> device, D3D12_HEAP_TYPE heapType = D3D12_HEAP_TYPE_DEFAULT, UINT64 heapSize = HeapSuballocator::defaultHeapSize) :
+			device{ std::move(device) },
+			heapProperties{ .Type = heapType, .CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN, .MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN },
+			heapTier{ this->device->CheckFeatureSupport<D3D12_FEATURE_D3D12_OPTIONS>().ResourceHeapTier },
+			allocationInfoCache{ this->device },
+			suballocator{ heapSize }
+		{
+		}
+
+	public:
+		PlacedResource CreateResource(
+			const D3D12_RESOURCE_DESC& desc,
+			D3D12_RESOURCE_STATES initialState,
+			const D3D12_CLEAR_VALUE* optOptimizedClearValue)
+		{
+			D3D12_RESOURCE_ALLOCATION_INFO info = allocationInfoCache.GetResourceAllocationInfo(desc);
+			if(info.SizeInBytes == UINT64_MAX)
+				throw std::invalid_argument("Invalid resource description");
+
+			HeapAllocation allocation = Allocate(info, GetHeapCategory(desc, heapTier));
+			try
+			{
+				Wrapper<ID3D12Resource> resource = device->CreatePlacedResource(GetHeap(allocation), allocation.GetOffset(), desc, initialState, optOptimizedClearValue);
+				return { std::move(resource), allocation };
+			}
+			catch(...)
+			{
+				Free(allocation);
+				throw;
+			}
+		}
+
+		HeapAllocation Allocate(const D3D12_RESOURCE_ALLOCATION_INFO& info, HeapCategory category)
+		{
+			std::scoped_lock lock{ mutex };
+			HeapAllocation allocation = suballocator.Allocate(info, category);
+
+			std::vector<Wrapper<ID3D12Heap>>& categoryHeaps = heaps[static_cast<size_t>(category)];
+			if(allocation.heapIndex == categoryHeaps.size())
+			{
+				const bool holdsTextures = category != HeapCategory::Buffers;
+				D3D12_HEAP_DESC heapDesc
+				{
+					.SizeInBytes = suballocator.GetHeap(category, allocation.heapIndex).GetCapacity(),
+					.Properties = heapProperties,
+					.Alignment = holdsTextures ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+					.Flags = GetHeapCategoryFlags(category)
+				};
+
+				try
+				{
+					categoryHeaps.push_back(device->CreateHeap(heapDesc));
+				}
+				catch(...)
+				{
+					suballocator.Free(allocation);
+					suballocator.PopHeap(category);
+					throw;
+				}
+			}
+
+			return allocation;
+		}
+
+		void Free(const HeapAllocation& allocation)
+		{
+			std::scoped_lock lock{ mutex };
+			suballocator.Free(allocation);
+		}
+
+		WrapperView<ID3D12Heap> GetHeap(const HeapAllocation& allocation)
+		{
+			std::scoped_lock lock{ mutex };
+			return heaps[static_cast<size_t>(allocation.category)][allocation.heapIndex];
+		}
+
+		D3D12_RESOURCE_HEAP_TIER GetResourceHeapTier() const noexcept { return heapTier; }
+		ResourceAllocationInfoCache& GetAllocationInfoCache() noexcept { return allocationInfoCache; }
+	};
+}
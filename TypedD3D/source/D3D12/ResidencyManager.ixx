@@ -0,0 +1,284 @@
+module;
+
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+#include <gsl/pointers>
+
+export module TypedD3D12:ResidencyManager;
+import TypedD3D.Shared;
+import :Device;
+import :CommandQueue;
+
+namespace TypedD3D::D3D12
+{
+	/// <summary>
+	/// Keeps the pageables used by submissions resident within the adapter's video memory budget.
+	/// Each tracked pageable remembers the fence value of the last submission using it on every queue, and sits in an LRU list.
+	/// Before a submission, non resident pageables are made resident with EnqueueMakeResident and the queue Waits on the GPU for it,
+	/// so the submitting thread never blocks. When that would go over budget, least recently used pageables that the GPU
+	/// is done with are evicted in a single batch.
+	/// Thread safe
+	/// </summary>
+	export class ResidencyManager
+	{
+	public:
+		static constexpr UINT maxQueues = 4;
+
+		class ManagedObject
+		{
+			friend class ResidencyManager;
+
+			ID3D12Pageable* pageable;
+			UINT64 size;
+			std::array<UINT64, maxQueues> lastUsedFenceValues = {};
+			bool resident = true;
+			std::list<ManagedObject*>::iterator lruPosition;
+
+		public:
+			ManagedObject(ID3D12Pageable* pageable, UINT64 size) :
+				pageable{ pageable },
+				size{ size }
+			{
+			}
+
+			bool IsResident() const noexcept { return resident; }
+			UINT64 GetSize() const noexcept { return size; }
+		};
+
+		using Handle = ManagedObject*;
+
+		/// <summary>
+		/// The pageables referenced by the command lists of a submission
+		/// </summary>
+		class ResidencySet
+		{
+			friend class ResidencyManager;
+			std::vector<Handle> objects;
+
+		public:
+			void Insert(Handle object) { objects.push_back(object); }
+			void Clear() { objects.clear(); }
+			size_t Size() const noexcept { return objects.size(); }
+		};
+
+		struct Statistics
+		{
+			UINT64 budget = 0;
+			UINT64 currentUsage = 0;
+			UINT64 madeResidentBytes = 0;
+			UINT64 evictedBytes = 0;
+			UINT64 evictionBatches = 0;
+		};
+
+	private:
+		struct QueueTimeline
+		{
+			Wrapper<ID3D12Fence> fence;
+			UINT64 nextValue = 1;
+		};
+
+		Wrapper<ID3D12Device3> device;
+		Wrapper<IUnknown> adapterLifetime;
+		IDXGIAdapter3* adapter;
+		UINT nodeIndex;
+
+		std::mutex mutex;
+		std::list<std::unique_ptr<ManagedObject>> objects;
+
+		//Front is the least recently used
+		std::list<ManagedObject*> lru;
+		std::vector<QueueTimeline> queues;
+
+		Wrapper<ID3D12Fence> residencyFence;
+		UINT64 residencyFenceValue = 0;
+
+		Statistics statistics;
+
+	public:
+		ResidencyManager(Wrapper<ID3D12Device3> device, IDXGIAdapter3& adapter, UINT nodeIndex = 0) :
+			device{ std::move(device) },
+			adapterLifetime{ &adapter },
+			adapter{ &adapter },
+			nodeIndex{ nodeIndex }
+		{
+			residencyFence = this->device->CreateFence(0, D3D12_FENCE_FLAG_NONE);
+		}
+
+		ResidencyManager(const ResidencyManager&) = delete;
+		ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+	public:
+		/// <summary>
+		/// Returns the index used to identify the queue in ExecuteCommandLists. At most maxQueues can be registered
+		/// </summary>
+		UINT RegisterQueue()
+		{
+			std::scoped_lock lock{ mutex };
+			assert(queues.size() < maxQueues);
+			queues.push_back({ device->CreateFence(0, D3D12_FENCE_FLAG_NONE) });
+			return static_cast<UINT>(queues.size() - 1);
+		}
+
+		/// <summary>
+		/// Starts tracking a pageable, newly created pageables are resident.
+		/// The pageable must outlive its tracking
+		/// </summary>
+		Handle Track(ID3D12Pageable* pageable, UINT64 size)
+		{
+			std::scoped_lock lock{ mutex };
+			ManagedObject* object = objects.emplace_back(std::make_unique<ManagedObject>(pageable, size)).get();
+			object->lruPosition = lru.insert(lru.end(), object);
+			return object;
+		}
+
+		void Untrack(Handle object)
+		{
+			std::scoped_lock lock{ mutex };
+			lru.erase(object->lruPosition);
+			objects.remove_if([object](const std::unique_ptr<ManagedObject>& o) { return o.get() == object; });
+		}
+
+		/// <summary>
+		/// Makes every pageable of the sets resident before the queue executes anything submitted after this call.
+		/// Call EndSubmission after ExecuteCommandLists so the pageables are known to be in use until the submission completes
+		/// </summary>
+		template<class QueueTy>
+		void PrepareSubmission(QueueTy& queue, UINT queueIndex, std::span<const ResidencySet* const> sets)
+		{
+			std::scoped_lock lock{ mutex };
+			assert(queueIndex < queues.size());
+
+			const UINT64 submissionValue = queues[queueIndex].nextValue;
+
+			std::vector<ManagedObject*> used;
+			for(const ResidencySet* set : sets)
+				used.insert(used.end(), set->objects.begin(), set->objects.end());
+			std::ranges::sort(used);
+			used.erase(std::unique(used.begin(), used.end()), used.end());
+
+			std::vector<ID3D12Pageable*> toMakeResident;
+			UINT64 bytesToMakeResident = 0;
+			for(ManagedObject* object : used)
+			{
+				object->lastUsedFenceValues[queueIndex] = submissionValue;
+				lru.splice(lru.end(), lru, object->lruPosition);
+
+				if(!object->resident)
+				{
+					toMakeResident.push_back(object->pageable);
+					bytesToMakeResident += object->size;
+				}
+			}
+
+			if(toMakeResident.empty())
+				return;
+
+			DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = QueryVideoMemoryInfo();
+			if(memoryInfo.CurrentUsage + bytesToMakeResident > memoryInfo.Budget)
+				EvictUnused(memoryInfo.CurrentUsage + bytesToMakeResident - memoryInfo.Budget, submissionValue, queueIndex);
+
+			try
+			{
+				device->EnqueueMakeResident(D3D12_RESIDENCY_FLAG_NONE, toMakeResident, residencyFence, residencyFenceValue + 1);
+			}
+			catch(const HRESULTError& error)
+			{
+				if(error.GetError() != E_OUTOFMEMORY)
+					throw;
+
+				//Budgets are a hint, free everything that isn't needed and try once more
+				EvictUnused(UINT64_MAX, submissionValue, queueIndex);
+				device->EnqueueMakeResident(D3D12_RESIDENCY_FLAG_NONE, toMakeResident, residencyFence, residencyFenceValue + 1);
+			}
+
+			residencyFenceValue++;
+			for(ManagedObject* object : used)
+				object->resident = true;
+			statistics.madeResidentBytes += bytesToMakeResident;
+
+			ThrowIfFailed(queue->Wait(residencyFence, residencyFenceValue));
+		}
+
+		template<class QueueTy>
+		void EndSubmission(QueueTy& queue, UINT queueIndex)
+		{
+			std::scoped_lock lock{ mutex };
+			QueueTimeline& timeline = queues[queueIndex];
+			ThrowIfFailed(queue->Signal(timeline.fence, timeline.nextValue));
+			timeline.nextValue++;
+		}
+
+		template<class QueueTy, class CommandListSpan>
+		void ExecuteCommandLists(QueueTy& queue, UINT queueIndex, CommandListSpan commandLists, std::span<const ResidencySet* const> sets)
+		{
+			PrepareSubmission(queue, queueIndex, sets);
+			queue->ExecuteCommandLists(commandLists);
+			EndSubmission(queue, queueIndex);
+		}
+
+		Statistics GetStatistics()
+		{
+			std::scoped_lock lock{ mutex };
+			DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = QueryVideoMemoryInfo();
+			statistics.budget = memoryInfo.Budget;
+			statistics.currentUsage = memoryInfo.CurrentUsage;
+			return statistics;
+		}
+
+	private:
+		DXGI_QUERY_VIDEO_MEMORY_INFO QueryVideoMemoryInfo()
+		{
+			DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo{};
+			ThrowIfFailed(adapter->QueryVideoMemoryInfo(nodeIndex, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo));
+			return memoryInfo;
+		}
+
+		//Evicts least recently used pageables which aren't used by the pending submission and which every queue is done with
+		void EvictUnused(UINT64 bytesToFree, UINT64 submissionValue, UINT queueIndex)
+		{
+			std::array<UINT64, maxQueues> completedValues = {};
+			for(size_t i = 0; i < queues.size(); i++)
+				completedValues[i] = queues[i].fence->GetCompletedValue();
+
+			std::vector<ID3D12Pageable*> toEvict;
+			UINT64 freedBytes = 0;
+			for(ManagedObject* object : lru)
+			{
+				if(freedBytes >= bytesToFree)
+					break;
+
+				if(object->lastUsedFenceValues[queueIndex] == submissionValue)
+					break;
+
+				if(!object->resident)
+					continue;
+
+				bool idle = true;
+				for(size_t i = 0; i < queues.size(); i++)
+					idle = idle && object->lastUsedFenceValues[i] <= completedValues[i];
+
+				if(!idle)
+					continue;
+
+				toEvict.push_back(object->pageable);
+				object->resident = false;
+				freedBytes += object->size;
+			}
+
+			if(toEvict.empty())
+				return;
+
+			device->Evict(toEvict);
+			statistics.evictedBytes += freedBytes;
+			statistics.evictionBatches++;
+		}
+	};
+}
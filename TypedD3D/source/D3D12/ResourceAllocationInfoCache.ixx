@@ -0,0 +1,189 @@
+module;
+
+#include <d3d12.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+export module TypedD3D12:ResourceAllocationInfoCache;
+import TypedD3D.Shared;
+import :Device;
+
+namespace TypedD3D::D3D12
+{
+	/// <summary>
+	/// Builds a key out of the fields of a resource description, skipping the struct's padding.
+	/// Buffers are canonicalized as the runtime sees them: a 0 alignment means 64KB
+	/// </summary>
+	export HashKey MakeResourceDescKey(const D3D12_RESOURCE_DESC& desc)
+	{
+		UINT64 alignment = desc.Alignment;
+		if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER && alignment == 0)
+			alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+		HashKey key;
+		key.Append(desc.Dimension)
+			.Append(alignment)
+			.Append(desc.Width)
+			.Append(desc.Height)
+			.Append(desc.DepthOrArraySize)
+			.Append(desc.MipLevels)
+			.Append(desc.Format)
+			.Append(desc.SampleDesc.Count)
+			.Append(desc.SampleDesc.Quality)
+			.Append(desc.Layout)
+			.Append(desc.Flags);
+		return key;
+	}
+
+	export using ResourceDescId = UINT32;
+
+	/// <summary>
+	/// Memoizes GetResourceAllocationInfo, which is an expensive driver call.
+	/// Identical descriptions are interned into small, dense ResourceDescIds which can be used to bucket resources cheaply.
+	/// Thread safe, lookups only take a shared lock
+	/// </summary>
+	export class ResourceAllocationInfoCache
+	{
+	public:
+		struct Statistics
+		{
+			UINT64 hits = 0;
+			UINT64 misses = 0;
+			UINT32 internedDescs = 0;
+
+			double GetHitRate() const noexcept { return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses); }
+		};
+
+	private:
+		struct Entry
+		{
+			D3D12_RESOURCE_DESC desc;
+			D3D12_RESOURCE_ALLOCATION_INFO info;
+		};
+
+		Wrapper<ID3D12Device> device;
+		UINT visibleMask;
+
+		std::shared_mutex mutex;
+
+		//Deque so that entries keep their address while new ones are interned
+		std::deque<Entry> entries;
+		std::unordered_map<HashKey, ResourceDescId, HashKeyHasher> ids;
+		std::unordered_map<HashKey, D3D12_RESOURCE_ALLOCATION_INFO, HashKeyHasher> arrayInfos;
+
+		std::atomic<UINT64> hits = 0;
+		std::atomic<UINT64> misses = 0;
+
+	public:
+		ResourceAllocationInfoCache(Wrapper<ID3D12Device> device, UINT visibleMask = 0) :
+			device{ std::move(device) },
+			visibleMask{ visibleMask }
+		{
+		}
+
+		ResourceAllocationInfoCache(const ResourceAllocationInfoCache&) = delete;
+		ResourceAllocationInfoCache& operator=(const ResourceAllocationInfoCache&) = delete;
+
+	public:
+		/// <summary>
+		/// Returns the id of the description, querying its allocation info the first time it is seen
+		/// </summary>
+		ResourceDescId Intern(const D3D12_RESOURCE_DESC& desc)
+		{
+			HashKey key = MakeResourceDescKey(desc);
+			{
+				std::shared_lock lock{ mutex };
+				if(auto it = ids.find(key); it != ids.end())
+				{
+					hits.fetch_add(1, std::memory_order_relaxed);
+					return it->second;
+				}
+			}
+
+			//Query outside of the lock so that other threads aren't held up by the driver
+			D3D12_RESOURCE_DESC resourceDesc = desc;
+			D3D12_RESOURCE_ALLOCATION_INFO info = device->GetResourceAllocationInfo(visibleMask, std::span(&resourceDesc, 1));
+
+			std::unique_lock lock{ mutex };
+			auto [it, inserted] = ids.try_emplace(std::move(key), static_cast<ResourceDescId>(entries.size()));
+			if(inserted)
+			{
+				entries.push_back({ desc, info });
+				misses.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				hits.fetch_add(1, std::memory_order_relaxed);
+			}
+			return it->second;
+		}
+
+		D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(const D3D12_RESOURCE_DESC& desc)
+		{
+			return GetResourceAllocationInfo(Intern(desc));
+		}
+
+		D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(ResourceDescId id)
+		{
+			std::shared_lock lock{ mutex };
+			return entries[id].info;
+		}
+
+		/// <summary>
+		/// The allocation info of several resources placed contiguously in the order given
+		/// </summary>
+		D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(std::span<const D3D12_RESOURCE_DESC> descs)
+		{
+			if(descs.size() == 1)
+				return GetResourceAllocationInfo(descs.front());
+
+			HashKey key;
+			key.Append(descs.size());
+			for(const D3D12_RESOURCE_DESC& desc : descs)
+				key.AppendBytes(MakeResourceDescKey(desc).GetBytes());
+
+			{
+				std::shared_lock lock{ mutex };
+				if(auto it = arrayInfos.find(key); it != arrayInfos.end())
+				{
+					hits.fetch_add(1, std::memory_order_relaxed);
+					return it->second;
+				}
+			}
+
+			std::vector<D3D12_RESOURCE_DESC> resourceDescs(descs.begin(), descs.end());
+			D3D12_RESOURCE_ALLOCATION_INFO info = device->GetResourceAllocationInfo(visibleMask, resourceDescs);
+
+			std::unique_lock lock{ mutex };
+			if(arrayInfos.try_emplace(std::move(key), info).second)
+				misses.fetch_add(1, std::memory_order_relaxed);
+			else
+				hits.fetch_add(1, std::memory_order_relaxed);
+			return info;
+		}
+
+		D3D12_RESOURCE_DESC GetDesc(ResourceDescId id)
+		{
+			std::shared_lock lock{ mutex };
+			return entries[id].desc;
+		}
+
+		Statistics GetStatistics()
+		{
+			std::shared_lock lock{ mutex };
+			return
+			{
+				.hits = hits.load(std::memory_order_relaxed),
+				.misses = misses.load(std::memory_order_relaxed),
+				.internedDescs = static_cast<UINT32>(entries.size())
+			};
+		}
+
+		UINT GetVisibleMask() const noexcept { return visibleMask; }
+	};
+}
@@ -0,0 +1,191 @@
+module;
+
+#include <d3d12.h>
+#include <cstddef>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <gsl/pointers>
+
+export module TypedD3D12:RootSignatureCache;
+import TypedD3D.Shared;
+import :Device;
+
+namespace TypedD3D::D3D12
+{
+	void AppendRootParameter(HashKey& key, const D3D12_ROOT_PARAMETER& parameter)
+	{
+		key.Append(parameter.ParameterType).Append(parameter.ShaderVisibility);
+		switch(parameter.ParameterType)
+		{
+		case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+			key.Append(std::span<const D3D12_DESCRIPTOR_RANGE>{ parameter.DescriptorTable.pDescriptorRanges, parameter.DescriptorTable.NumDescriptorRanges });
+			break;
+		case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+			key.Append(parameter.Constants);
+			break;
+		default:
+			key.Append(parameter.Descriptor);
+			break;
+		}
+	}
+
+	void AppendRootParameter(HashKey& key, const D3D12_ROOT_PARAMETER1& parameter)
+	{
+		key.Append(parameter.ParameterType).Append(parameter.ShaderVisibility);
+		switch(parameter.ParameterType)
+		{
+		case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+			key.Append(std::span<const D3D12_DESCRIPTOR_RANGE1>{ parameter.DescriptorTable.pDescriptorRanges, parameter.DescriptorTable.NumDescriptorRanges });
+			break;
+		case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+			key.Append(parameter.Constants);
+			break;
+		default:
+			key.Append(parameter.Descriptor);
+			break;
+		}
+	}
+
+	template<class RootSignatureDesc>
+	void AppendRootSignature(HashKey& key, const RootSignatureDesc& desc)
+	{
+		key.Append(desc.NumParameters);
+		for(UINT i = 0; i < desc.NumParameters; i++)
+			AppendRootParameter(key, desc.pParameters[i]);
+
+		key.Append(std::span<const D3D12_STATIC_SAMPLER_DESC>{ desc.pStaticSamplers, desc.NumStaticSamplers });
+		key.Append(desc.Flags);
+	}
+
+	/// <summary>
+	/// Builds a canonical key out of a versioned root signature description.
+	/// Pointers are followed so that two descriptions describing the same layout produce the same key regardless of where they live in memory
+	/// </summary>
+	export HashKey MakeRootSignatureKey(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc)
+	{
+		HashKey key;
+		key.Append(desc.Version);
+		switch(desc.Version)
+		{
+		case D3D_ROOT_SIGNATURE_VERSION_1_0:
+			AppendRootSignature(key, desc.Desc_1_0);
+			break;
+		case D3D_ROOT_SIGNATURE_VERSION_1_1:
+			AppendRootSignature(key, desc.Desc_1_1);
+			break;
+		default:
+			throw std::invalid_argument("Unsupported root signature version");
+		}
+		return key;
+	}
+
+	export Wrapper<ID3DBlob> SerializeVersionedRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc)
+	{
+		Wrapper<ID3DBlob> signatureBlob;
+		Wrapper<ID3DBlob> errorBlob;
+		HRESULT result = D3D12SerializeVersionedRootSignature(&desc, OutPtr{ signatureBlob }, OutPtr{ errorBlob });
+		if(FAILED(result))
+		{
+			if(errorBlob)
+				throw HRESULTError(result, std::string(static_cast<const char*>(errorBlob->GetBufferPointer()), errorBlob->GetBufferSize()));
+			ThrowIfFailed(result);
+		}
+		return signatureBlob;
+	}
+
+	/// <summary>
+	/// Deduplicates root signatures created through it.
+	/// Serialization is memoized on the root signature description, and root signatures are keyed on the serialized blob,
+	/// so identical layouts always resolve to the same ID3D12RootSignature.
+	/// Thread safe
+	/// </summary>
+	export class RootSignatureCache
+	{
+		Wrapper<ID3D12Device> device;
+		UINT nodeMask = 0;
+
+		mutable std::mutex mutex;
+		std::unordered_map<HashKey, Wrapper<ID3DBlob>, HashKeyHasher> serializedBlobs;
+		std::unordered_map<HashKey, Wrapper<ID3D12RootSignature>, HashKeyHasher> rootSignatures;
+
+	public:
+		RootSignatureCache() = default;
+		RootSignatureCache(Wrapper<ID3D12Device> device, UINT nodeMask = 0) :
+			device{ std::move(device) },
+			nodeMask{ nodeMask }
+		{
+		}
+
+	public:
+		Wrapper<ID3DBlob> Serialize(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc)
+		{
+			HashKey key = MakeRootSignatureKey(desc);
+			{
+				std::scoped_lock lock{ mutex };
+				if(auto it = serializedBlobs.find(key); it != serializedBlobs.end())
+					return it->second;
+			}
+
+			//Serialization can be slow, keep it outside of the lock. Whoever inserts first wins
+			Wrapper<ID3DBlob> blob = SerializeVersionedRootSignature(desc);
+
+			std::scoped_lock lock{ mutex };
+			return serializedBlobs.try_emplace(std::move(key), std::move(blob)).first->second;
+		}
+
+		Wrapper<ID3D12RootSignature> GetOrCreate(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc)
+		{
+			Wrapper<ID3DBlob> blob = Serialize(desc);
+			return GetOrCreate(blob->GetBufferPointer(), blob->GetBufferSize());
+		}
+
+		Wrapper<ID3D12RootSignature> GetOrCreate(const D3D12_ROOT_SIGNATURE_DESC& desc)
+		{
+			D3D12_VERSIONED_ROOT_SIGNATURE_DESC versionedDesc{ .Version = D3D_ROOT_SIGNATURE_VERSION_1_0 };
+			versionedDesc.Desc_1_0 = desc;
+			return GetOrCreate(versionedDesc);
+		}
+
+		Wrapper<ID3D12RootSignature> GetOrCreate(gsl::not_null<WrapperView<ID3DBlob>> blobWithRootSignature)
+		{
+			return GetOrCreate(blobWithRootSignature->GetBufferPointer(), blobWithRootSignature->GetBufferSize());
+		}
+
+		Wrapper<ID3D12RootSignature> GetOrCreate(const void* pBlobWithRootSignature, SIZE_T blobLengthInBytes)
+		{
+			HashKey key;
+			key.AppendBytes(std::span{ static_cast<const std::byte*>(pBlobWithRootSignature), blobLengthInBytes });
+
+			std::scoped_lock lock{ mutex };
+			if(auto it = rootSignatures.find(key); it != rootSignatures.end())
+				return it->second;
+
+			//Creation stays under the lock so that racing callers never end up with 2 different root signatures for the same blob
+			Wrapper<ID3D12RootSignature> rootSignature = device->CreateRootSignature(nodeMask, pBlobWithRootSignature, blobLengthInBytes);
+			return rootSignatures.emplace(std::move(key), std::move(rootSignature)).first->second;
+		}
+
+		void Clear()
+		{
+			std::scoped_lock lock{ mutex };
+			serializedBlobs.clear();
+			rootSignatures.clear();
+		}
+
+	public:
+		size_t GetSerializedBlobCount() const
+		{
+			std::scoped_lock lock{ mutex };
+			return serializedBlobs.size();
+		}
+
+		size_t GetRootSignatureCount() const
+		{
+			std::scoped_lock lock{ mutex };
+			return rootSignatures.size();
+		}
+	};
+}
@@ -0,0 +1,307 @@
+module;
+
+#include <d3d12.h>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <gsl/pointers>
+
+export module TypedD3D12:RootSignatureLayout;
+import TypedD3D.Shared;
+import :Wrappers;
+import :Device;
+import :RootSignatureCache;
+
+namespace TypedD3D::D3D12
+{
+	//Root signatures are limited to 64 DWORDs, tables cost 1, root descriptors cost 2 and constants cost 1 per 32 bit value
+	constexpr UINT maxRootSignatureCost = 64;
+
+	export template<D3D12_DESCRIPTOR_RANGE_TYPE Type,
+		UINT NumDescriptors,
+		UINT BaseShaderRegister,
+		UINT RegisterSpace = 0,
+		D3D12_DESCRIPTOR_RANGE_FLAGS Flags = D3D12_DESCRIPTOR_RANGE_FLAG_NONE,
+		UINT OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND>
+	struct DescriptorRange
+	{
+		static constexpr D3D12_DESCRIPTOR_RANGE_TYPE rangeType = Type;
+		static constexpr D3D12_DESCRIPTOR_RANGE1 range
+		{
+			.RangeType = Type,
+			.NumDescriptors = NumDescriptors,
+			.BaseShaderRegister = BaseShaderRegister,
+			.RegisterSpace = RegisterSpace,
+			.Flags = Flags,
+			.OffsetInDescriptorsFromTableStart = OffsetInDescriptorsFromTableStart
+		};
+	};
+
+	/// <summary>
+	/// Root constants whose contents are described by Ty
+	/// </summary>
+	export template<class Ty, UINT ShaderRegister, UINT RegisterSpace = 0, D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+		requires std::is_trivially_copyable_v<Ty> && (sizeof(Ty) % sizeof(UINT) == 0)
+	struct RootConstants
+	{
+		using value_type = Ty;
+		static constexpr D3D12_ROOT_PARAMETER_TYPE parameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+		static constexpr UINT num32BitValues = sizeof(Ty) / sizeof(UINT);
+		static constexpr UINT cost = num32BitValues;
+
+		static constexpr D3D12_ROOT_PARAMETER1 MakeParameter()
+		{
+			D3D12_ROOT_PARAMETER1 parameter{};
+			parameter.ParameterType = parameterType;
+			parameter.Constants = { ShaderRegister, RegisterSpace, num32BitValues };
+			parameter.ShaderVisibility = Visibility;
+			return parameter;
+		}
+	};
+
+	template<D3D12_ROOT_PARAMETER_TYPE Type, UINT ShaderRegister, UINT RegisterSpace, D3D12_ROOT_DESCRIPTOR_FLAGS Flags, D3D12_SHADER_VISIBILITY Visibility>
+	struct RootDescriptor
+	{
+		static constexpr D3D12_ROOT_PARAMETER_TYPE parameterType = Type;
+		static constexpr UINT cost = 2;
+
+		static constexpr D3D12_ROOT_PARAMETER1 MakeParameter()
+		{
+			D3D12_ROOT_PARAMETER1 parameter{};
+			parameter.ParameterType = parameterType;
+			parameter.Descriptor = { ShaderRegister, RegisterSpace, Flags };
+			parameter.ShaderVisibility = Visibility;
+			return parameter;
+		}
+	};
+
+	export template<UINT ShaderRegister, UINT RegisterSpace = 0, D3D12_ROOT_DESCRIPTOR_FLAGS Flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+	using RootCBV = RootDescriptor<D3D12_ROOT_PARAMETER_TYPE_CBV, ShaderRegister, RegisterSpace, Flags, Visibility>;
+
+	export template<UINT ShaderRegister, UINT RegisterSpace = 0, D3D12_ROOT_DESCRIPTOR_FLAGS Flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+	using RootSRV = RootDescriptor<D3D12_ROOT_PARAMETER_TYPE_SRV, ShaderRegister, RegisterSpace, Flags, Visibility>;
+
+	export template<UINT ShaderRegister, UINT RegisterSpace = 0, D3D12_ROOT_DESCRIPTOR_FLAGS Flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+	using RootUAV = RootDescriptor<D3D12_ROOT_PARAMETER_TYPE_UAV, ShaderRegister, RegisterSpace, Flags, Visibility>;
+
+	/// <summary>
+	/// A descriptor table made of Ranges.
+	/// Sampler ranges cannot be mixed with CBV, SRV or UAV ranges, which decides which kind of GPU handle the table binds to
+	/// </summary>
+	export template<D3D12_SHADER_VISIBILITY Visibility, class... Ranges>
+		requires (sizeof...(Ranges) > 0)
+	struct RootDescriptorTable
+	{
+		static constexpr bool isSamplerTable = ((Ranges::rangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER) && ...);
+		static_assert(isSamplerTable || ((Ranges::rangeType != D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER) && ...), "Sampler ranges cannot share a descriptor table with CBV, SRV or UAV ranges");
+
+		using handle_type = std::conditional_t<isSamplerTable, Sampler<D3D12_GPU_DESCRIPTOR_HANDLE>, CBV_SRV_UAV<D3D12_GPU_DESCRIPTOR_HANDLE>>;
+
+		static constexpr D3D12_ROOT_PARAMETER_TYPE parameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		static constexpr UINT cost = 1;
+		static constexpr std::array<D3D12_DESCRIPTOR_RANGE1, sizeof...(Ranges)> ranges{ Ranges::range... };
+
+		static constexpr D3D12_ROOT_PARAMETER1 MakeParameter()
+		{
+			D3D12_ROOT_PARAMETER1 parameter{};
+			parameter.ParameterType = parameterType;
+			parameter.DescriptorTable = { static_cast<UINT>(ranges.size()), ranges.data() };
+			parameter.ShaderVisibility = Visibility;
+			return parameter;
+		}
+	};
+
+	export template<D3D12_STATIC_SAMPLER_DESC... Samplers>
+	struct StaticSamplers
+	{
+		static constexpr std::array<D3D12_STATIC_SAMPLER_DESC, sizeof...(Samplers)> samplers{ Samplers... };
+	};
+
+	template<class Ty>
+	concept RootParameterDescription = requires
+	{
+		{ Ty::parameterType } -> std::convertible_to<D3D12_ROOT_PARAMETER_TYPE>;
+		{ Ty::cost } -> std::convertible_to<UINT>;
+		{ Ty::MakeParameter() } -> std::same_as<D3D12_ROOT_PARAMETER1>;
+	};
+
+	/// <summary>
+	/// A root signature described entirely at compile time.
+	/// Root parameter indices are the position of the parameter in Parameters.
+	/// The serialized blob is produced once per layout and reused afterwards
+	/// </summary>
+	export template<D3D12_ROOT_SIGNATURE_FLAGS Flags, class Samplers, RootParameterDescription... Parameters>
+	struct BasicRootSignatureLayout
+	{
+		static_assert((Parameters::cost + ... + 0) <= maxRootSignatureCost, "Root signature exceeds the 64 DWORD limit");
+
+		static constexpr UINT parameterCount = sizeof...(Parameters);
+
+		template<UINT Index>
+			requires (Index < parameterCount)
+		using parameter_type = std::tuple_element_t<Index, std::tuple<Parameters...>>;
+
+		static constexpr std::array<D3D12_ROOT_PARAMETER1, parameterCount> parameters{ Parameters::MakeParameter()... };
+
+		static constexpr D3D12_VERSIONED_ROOT_SIGNATURE_DESC GetDesc()
+		{
+			D3D12_VERSIONED_ROOT_SIGNATURE_DESC desc{};
+			desc.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
+			desc.Desc_1_1 =
+			{
+				.NumParameters = parameterCount,
+				.pParameters = parameters.data(),
+				.NumStaticSamplers = static_cast<UINT>(Samplers::samplers.size()),
+				.pStaticSamplers = Samplers::samplers.data(),
+				.Flags = Flags
+			};
+			return desc;
+		}
+
+		static Wrapper<ID3DBlob> GetSerialized()
+		{
+			static const Wrapper<ID3DBlob> blob = SerializeVersionedRootSignature(GetDesc());
+			return blob;
+		}
+
+		static Wrapper<ID3D12RootSignature> Create(gsl::not_null<WrapperView<ID3D12Device>> device, UINT nodeMask = 0)
+		{
+			Wrapper<ID3DBlob> blob = GetSerialized();
+			return device->CreateRootSignature(nodeMask, blob->GetBufferPointer(), blob->GetBufferSize());
+		}
+
+		static Wrapper<ID3D12RootSignature> Create(RootSignatureCache& cache)
+		{
+			return cache.GetOrCreate(GetSerialized());
+		}
+	};
+
+	export template<D3D12_ROOT_SIGNATURE_FLAGS Flags, class... Parameters>
+	using RootSignatureLayout = BasicRootSignatureLayout<Flags, StaticSamplers<>, Parameters...>;
+
+	template<class Ty>
+	concept RootConstantsDescription = RootParameterDescription<Ty> && Ty::parameterType == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+
+	template<class Ty>
+	concept RootDescriptorDescription = RootParameterDescription<Ty>
+		&& (Ty::parameterType == D3D12_ROOT_PARAMETER_TYPE_CBV
+			|| Ty::parameterType == D3D12_ROOT_PARAMETER_TYPE_SRV
+			|| Ty::parameterType == D3D12_ROOT_PARAMETER_TYPE_UAV);
+
+	template<class Ty>
+	concept RootDescriptorTableDescription = RootParameterDescription<Ty> && Ty::parameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+
+	struct GraphicsBindPoint
+	{
+		static void SetRootSignature(auto& commandList, WrapperView<ID3D12RootSignature> rootSignature) { commandList->SetGraphicsRootSignature(rootSignature); }
+		static void SetConstants(auto& commandList, UINT index, UINT count, const void* data, UINT offset) { commandList->SetGraphicsRoot32BitConstants(index, count, data, offset); }
+		static void SetTable(auto& commandList, UINT index, D3D12_GPU_DESCRIPTOR_HANDLE handle) { commandList->SetGraphicsRootDescriptorTable(index, handle); }
+
+		template<D3D12_ROOT_PARAMETER_TYPE Type>
+		static void SetDescriptor(auto& commandList, UINT index, D3D12_GPU_VIRTUAL_ADDRESS address)
+		{
+			if constexpr(Type == D3D12_ROOT_PARAMETER_TYPE_CBV)
+				commandList->SetGraphicsRootConstantBufferView(index, address);
+			else if constexpr(Type == D3D12_ROOT_PARAMETER_TYPE_SRV)
+				commandList->SetGraphicsRootShaderResourceView(index, address);
+			else
+				commandList->SetGraphicsRootUnorderedAccessView(index, address);
+		}
+	};
+
+	struct ComputeBindPoint
+	{
+		static void SetRootSignature(auto& commandList, WrapperView<ID3D12RootSignature> rootSignature) { commandList->SetComputeRootSignature(rootSignature); }
+		static void SetConstants(auto& commandList, UINT index, UINT count, const void* data, UINT offset) { commandList->SetComputeRoot32BitConstants(index, count, data, offset); }
+		static void SetTable(auto& commandList, UINT index, D3D12_GPU_DESCRIPTOR_HANDLE handle) { commandList->SetComputeRootDescriptorTable(index, handle); }
+
+		template<D3D12_ROOT_PARAMETER_TYPE Type>
+		static void SetDescriptor(auto& commandList, UINT index, D3D12_GPU_VIRTUAL_ADDRESS address)
+		{
+			if constexpr(Type == D3D12_ROOT_PARAMETER_TYPE_CBV)
+				commandList->SetComputeRootConstantBufferView(index, address);
+			else if constexpr(Type == D3D12_ROOT_PARAMETER_TYPE_SRV)
+				commandList->SetComputeRootShaderResourceView(index, address);
+			else
+				commandList->SetComputeRootUnorderedAccessView(index, address);
+		}
+	};
+
+	/// <summary>
+	/// Binds root arguments of Layout onto a command list.
+	/// Every index, size and offset is checked at compile time and forwards straight to the matching Set*Root* call
+	/// </summary>
+	template<class Layout, class CommandListTy, class BindPoint>
+	class RootBinder
+	{
+		CommandListTy& commandList;
+
+	public:
+		RootBinder(CommandListTy& commandList) :
+			commandList{ commandList }
+		{
+		}
+
+	public:
+		void SetRootSignature(WrapperView<ID3D12RootSignature> rootSignature)
+		{
+			BindPoint::SetRootSignature(commandList, rootSignature);
+		}
+
+		template<UINT Index>
+			requires RootConstantsDescription<typename Layout::template parameter_type<Index>>
+		void Set(const typename Layout::template parameter_type<Index>::value_type& constants)
+		{
+			using Parameter = typename Layout::template parameter_type<Index>;
+			BindPoint::SetConstants(commandList, Index, Parameter::num32BitValues, &constants, 0);
+		}
+
+		/// <summary>
+		/// Sets a sub range of the root constants at Index starting at DestOffsetIn32BitValues
+		/// </summary>
+		template<UINT Index, UINT DestOffsetIn32BitValues, class Ty>
+			requires RootConstantsDescription<typename Layout::template parameter_type<Index>>
+				&& std::is_trivially_copyable_v<Ty>
+				&& (sizeof(Ty) % sizeof(UINT) == 0)
+				&& (DestOffsetIn32BitValues + sizeof(Ty) / sizeof(UINT) <= Layout::template parameter_type<Index>::num32BitValues)
+		void SetConstants(const Ty& constants)
+		{
+			BindPoint::SetConstants(commandList, Index, sizeof(Ty) / sizeof(UINT), &constants, DestOffsetIn32BitValues);
+		}
+
+		template<UINT Index>
+			requires RootDescriptorDescription<typename Layout::template parameter_type<Index>>
+		void Set(D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+		{
+			using Parameter = typename Layout::template parameter_type<Index>;
+			BindPoint::template SetDescriptor<Parameter::parameterType>(commandList, Index, bufferLocation);
+		}
+
+		template<UINT Index>
+			requires RootDescriptorTableDescription<typename Layout::template parameter_type<Index>>
+		void Set(typename Layout::template parameter_type<Index>::handle_type baseDescriptor)
+		{
+			BindPoint::SetTable(commandList, Index, baseDescriptor.Raw());
+		}
+	};
+
+	export template<class Layout, class CommandListTy>
+	using GraphicsRootBinder = RootBinder<Layout, CommandListTy, GraphicsBindPoint>;
+
+	export template<class Layout, class CommandListTy>
+	using ComputeRootBinder = RootBinder<Layout, CommandListTy, ComputeBindPoint>;
+
+	export template<class Layout, class CommandListTy>
+	GraphicsRootBinder<Layout, CommandListTy> BindGraphicsRoot(CommandListTy& commandList)
+	{
+		return { commandList };
+	}
+
+	export template<class Layout, class CommandListTy>
+	ComputeRootBinder<Layout, CommandListTy> BindComputeRoot(CommandListTy& commandList)
+	{
+		return { commandList };
+	}
+}
@@ -0,0 +1,271 @@
+module;
+
+#include <d3d12.h>
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <gsl/pointers>
+
+export module TypedD3D12:SubmissionGraph;
+import TypedD3D.Shared;
+import :Device;
+import :CommandQueue;
+
+namespace TypedD3D::D3D12
+{
+	export constexpr size_t submissionQueueCount = 3;
+
+	export constexpr size_t GetSubmissionQueueIndex(D3D12_COMMAND_LIST_TYPE type)
+	{
+		switch(type)
+		{
+		case D3D12_COMMAND_LIST_TYPE_DIRECT: return 0;
+		case D3D12_COMMAND_LIST_TYPE_COMPUTE: return 1;
+		case D3D12_COMMAND_LIST_TYPE_COPY: return 2;
+		default: throw std::invalid_argument("Only direct, compute and copy queues can be scheduled");
+		}
+	}
+
+	export struct QueueWait
+	{
+		D3D12_COMMAND_LIST_TYPE queue;
+
+		//Relative to the start of the schedule, the first batch of every queue has a value of 1
+		UINT64 fenceValue;
+	};
+
+	export struct ScheduledBatch
+	{
+		D3D12_COMMAND_LIST_TYPE queue;
+		UINT64 fenceValue;
+
+		//Waits the queue must issue before executing the batch
+		std::vector<QueueWait> waits;
+
+		//Whether the queue has to signal fenceValue after executing the batch
+		bool signal = false;
+	};
+
+	export struct SubmissionSchedule
+	{
+		//In submission order, indexed by the batch id returned by SubmissionGraph::AddBatch
+		std::vector<ScheduledBatch> batches;
+		std::array<UINT64, submissionQueueCount> batchCounts = {};
+
+		size_t GetWaitCount() const noexcept
+		{
+			size_t count = 0;
+			for(const ScheduledBatch& batch : batches)
+				count += batch.waits.size();
+			return count;
+		}
+
+		size_t GetSignalCount() const noexcept
+		{
+			size_t count = 0;
+			for(const ScheduledBatch& batch : batches)
+				count += batch.signal;
+			return count;
+		}
+	};
+
+	/// <summary>
+	/// Batches of work submitted to the direct, compute and copy queues along with the batches they depend on.
+	/// Batches execute in the order they are added to their queue, so dependencies on the same queue are implicit.
+	/// Compile only emits the cross queue waits which aren't already implied by queue order or by another wait
+	/// </summary>
+	export class SubmissionGraph
+	{
+		struct Batch
+		{
+			D3D12_COMMAND_LIST_TYPE queue;
+			std::vector<UINT32> dependencies;
+		};
+
+		std::vector<Batch> batches;
+
+	public:
+		/// <summary>
+		/// Dependencies must be batches added before this one. Returns the id of the batch
+		/// </summary>
+		UINT32 AddBatch(D3D12_COMMAND_LIST_TYPE queue, std::span<const UINT32> dependencies = {})
+		{
+			GetSubmissionQueueIndex(queue);
+			const UINT32 id = static_cast<UINT32>(batches.size());
+			for(UINT32 dependency : dependencies)
+			{
+				if(dependency >= id)
+					throw std::invalid_argument("Batches can only depend on batches added before them");
+			}
+
+			batches.push_back({ queue, { dependencies.begin(), dependencies.end() } });
+			return id;
+		}
+
+		UINT32 AddBatch(D3D12_COMMAND_LIST_TYPE queue, std::initializer_list<UINT32> dependencies)
+		{
+			return AddBatch(queue, std::span(dependencies.begin(), dependencies.size()));
+		}
+
+		void Clear() { batches.clear(); }
+		size_t GetBatchCount() const noexcept { return batches.size(); }
+
+		SubmissionSchedule Compile() const
+		{
+			//Per batch, the highest fence value of every queue known to have completed once the batch is done
+			using VectorClock = std::array<UINT64, submissionQueueCount>;
+			std::vector<VectorClock> clocks(batches.size());
+			std::array<UINT32, submissionQueueCount> previousOnQueue;
+			previousOnQueue.fill(UINT32_MAX);
+
+			SubmissionSchedule schedule;
+			schedule.batches.reserve(batches.size());
+
+			for(UINT32 id = 0; id < batches.size(); id++)
+			{
+				const Batch& batch = batches[id];
+				const size_t queue = GetSubmissionQueueIndex(batch.queue);
+				const UINT64 fenceValue = ++schedule.batchCounts[queue];
+
+				VectorClock known = previousOnQueue[queue] == UINT32_MAX ? VectorClock{} : clocks[previousOnQueue[queue]];
+
+				//Waiting on the latest dependency of a queue covers all the earlier ones
+				std::array<UINT32, submissionQueueCount> latest;
+				latest.fill(UINT32_MAX);
+				for(UINT32 dependency : batch.dependencies)
+				{
+					const size_t dependencyQueue = GetSubmissionQueueIndex(batches[dependency].queue);
+					if(dependencyQueue == queue)
+						continue;
+
+					if(latest[dependencyQueue] == UINT32_MAX || schedule.batches[dependency].fenceValue > schedule.batches[latest[dependencyQueue]].fenceValue)
+						latest[dependencyQueue] = dependency;
+				}
+
+				auto IsImplied = [&](size_t waitQueue)
+				{
+					const UINT64 value = schedule.batches[latest[waitQueue]].fenceValue;
+					if(known[waitQueue] >= value)
+						return true;
+
+					for(size_t other = 0; other < submissionQueueCount; other++)
+					{
+						if(other != waitQueue && latest[other] != UINT32_MAX && clocks[latest[other]][waitQueue] >= value)
+							return true;
+					}
+					return false;
+				};
+
+				std::array<bool, submissionQueueCount> needed = {};
+				for(size_t waitQueue = 0; waitQueue < submissionQueueCount; waitQueue++)
+					needed[waitQueue] = latest[waitQueue] != UINT32_MAX && !IsImplied(waitQueue);
+
+				ScheduledBatch& scheduled = schedule.batches.emplace_back(ScheduledBatch{ .queue = batch.queue, .fenceValue = fenceValue });
+				for(size_t waitQueue = 0; waitQueue < submissionQueueCount; waitQueue++)
+				{
+					if(!needed[waitQueue])
+						continue;
+
+					ScheduledBatch& waitedOn = schedule.batches[latest[waitQueue]];
+					waitedOn.signal = true;
+					scheduled.waits.push_back({ waitedOn.queue, waitedOn.fenceValue });
+
+					for(size_t i = 0; i < submissionQueueCount; i++)
+						known[i] = std::max(known[i], clocks[latest[waitQueue]][i]);
+				}
+
+				known[queue] = fenceValue;
+				clocks[id] = known;
+				previousOnQueue[queue] = id;
+			}
+
+			return schedule;
+		}
+	};
+
+	/// <summary>
+	/// Submits SubmissionSchedules to a direct, compute and copy queue, owning one fence per queue.
+	/// Fence values keep increasing across schedules, GetLastSignaledValue of every queue covers everything submitted to it
+	/// </summary>
+	export class MultiQueueSubmitter
+	{
+		Direct<ID3D12CommandQueue> directQueue;
+		Compute<ID3D12CommandQueue> computeQueue;
+		Copy<ID3D12CommandQueue> copyQueue;
+
+		std::array<Wrapper<ID3D12Fence>, submissionQueueCount> fences;
+		std::array<UINT64, submissionQueueCount> baseValues = {};
+		std::array<UINT64, submissionQueueCount> lastSignaledValues = {};
+
+	public:
+		MultiQueueSubmitter(
+			gsl::not_null<WrapperView<ID3D12Device>> device,
+			Direct<ID3D12CommandQueue> directQueue,
+			Compute<ID3D12CommandQueue> computeQueue,
+			Copy<ID3D12CommandQueue> copyQueue) :
+			directQueue{ std::move(directQueue) },
+			computeQueue{ std::move(computeQueue) },
+			copyQueue{ std::move(copyQueue) }
+		{
+			for(Wrapper<ID3D12Fence>& fence : fences)
+				fence = device->CreateFence(0, D3D12_FENCE_FLAG_NONE);
+		}
+
+	public:
+		/// <summary>
+		/// executeBatch(batchId) is called in submission order and must execute the batch's command lists on the queue of the batch
+		/// </summary>
+		template<class Func>
+		void Submit(const SubmissionSchedule& schedule, Func&& executeBatch)
+		{
+			for(UINT32 id = 0; id < schedule.batches.size(); id++)
+			{
+				const ScheduledBatch& batch = schedule.batches[id];
+				const size_t queue = GetSubmissionQueueIndex(batch.queue);
+
+				for(const QueueWait& wait : batch.waits)
+				{
+					const size_t waitQueue = GetSubmissionQueueIndex(wait.queue);
+					VisitQueue(queue, [&](auto& commandQueue) { ThrowIfFailed(commandQueue->Wait(fences[waitQueue], baseValues[waitQueue] + wait.fenceValue)); });
+				}
+
+				executeBatch(id);
+
+				//The last batch of every queue is signaled so GetLastSignaledValue covers the whole schedule
+				if(batch.signal || batch.fenceValue == schedule.batchCounts[queue])
+				{
+					const UINT64 value = baseValues[queue] + batch.fenceValue;
+					VisitQueue(queue, [&](auto& commandQueue) { ThrowIfFailed(commandQueue->Signal(fences[queue], value)); });
+					lastSignaledValues[queue] = value;
+				}
+			}
+
+			for(size_t queue = 0; queue < submissionQueueCount; queue++)
+				baseValues[queue] += schedule.batchCounts[queue];
+		}
+
+	public:
+		Direct<ID3D12CommandQueue>& GetDirectQueue() noexcept { return directQueue; }
+		Compute<ID3D12CommandQueue>& GetComputeQueue() noexcept { return computeQueue; }
+		Copy<ID3D12CommandQueue>& GetCopyQueue() noexcept { return copyQueue; }
+
+		WrapperView<ID3D12Fence> GetFence(D3D12_COMMAND_LIST_TYPE queue) const { return fences[GetSubmissionQueueIndex(queue)]; }
+		UINT64 GetLastSignaledValue(D3D12_COMMAND_LIST_TYPE queue) const { return lastSignaledValues[GetSubmissionQueueIndex(queue)]; }
+
+	private:
+		template<class Func>
+		void VisitQueue(size_t queue, Func&& func)
+		{
+			switch(queue)
+			{
+			case 0: func(directQueue); break;
+			case 1: func(computeQueue); break;
+			default: func(copyQueue); break;
+			}
+		}
+	};
+}
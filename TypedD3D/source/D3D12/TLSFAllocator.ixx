@@ -0,0 +1,336 @@
+module;
+
+#include <d3d12.h>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+export module TypedD3D12:TLSFAllocator;
+
+namespace TypedD3D::D3D12
+{
+	/// <summary>
+	/// Two level segregated fit bookkeeping over a range of [0, capacity).
+	/// Only tracks offsets, it never touches memory, so it can be used for heaps, buffers or anything else that is sub-allocated.
+	/// Allocation and freeing are O(1)
+	/// </summary>
+	export class TLSFAllocator
+	{
+	public:
+		static constexpr UINT32 invalidBlock = UINT32_MAX;
+
+		struct Allocation
+		{
+			UINT64 offset = 0;
+			UINT64 size = 0;
+			UINT32 block = invalidBlock;
+
+			bool IsValid() const noexcept { return block != invalidBlock; }
+		};
+
+	private:
+		static constexpr UINT secondLevelBits = 5;
+		static constexpr UINT secondLevelCount = 1 << secondLevelBits;
+		static constexpr UINT firstLevelCount = 64 - secondLevelBits + 1;
+
+		struct Block
+		{
+			UINT64 offset = 0;
+			UINT64 size = 0;
+			UINT32 previousPhysical = invalidBlock;
+			UINT32 nextPhysical = invalidBlock;
+			UINT32 previousFree = invalidBlock;
+			UINT32 nextFree = invalidBlock;
+			bool free = false;
+		};
+
+		struct Mapping
+		{
+			UINT firstLevel;
+			UINT secondLevel;
+		};
+
+		UINT64 capacity = 0;
+		UINT64 freeSize = 0;
+		UINT32 allocationCount = 0;
+
+		std::vector<Block> blocks;
+		std::vector<UINT32> unusedBlocks;
+
+		UINT64 firstLevelBitmap = 0;
+		std::array<UINT32, firstLevelCount> secondLevelBitmaps = {};
+		std::array<std::array<UINT32, secondLevelCount>, firstLevelCount> freeLists;
+
+	public:
+		TLSFAllocator() = default;
+		TLSFAllocator(UINT64 capacity) :
+			capacity{ capacity }
+		{
+			for(auto& list : freeLists)
+				list.fill(invalidBlock);
+
+			if(capacity > 0)
+				InsertFreeBlock(NewBlock({ .offset = 0, .size = capacity }));
+			freeSize = capacity;
+		}
+
+	public:
+		/// <summary>
+		/// Returns nullopt if there is no free range large enough. alignment must be a power of 2
+		/// </summary>
+		std::optional<Allocation> Allocate(UINT64 size, UINT64 alignment = 1)
+		{
+			assert(std::has_single_bit(alignment));
+			if(size == 0 || size > freeSize)
+				return std::nullopt;
+
+			//Blocks are commonly already aligned, only over-request when the first candidate can't fit the allocation after being aligned
+			UINT32 blockIndex = FindFreeBlock(size);
+			if(blockIndex == invalidBlock || !Fits(blockIndex, size, alignment))
+			{
+				const UINT64 searchSize = size + alignment - 1;
+				if(searchSize < size)
+					return std::nullopt;
+
+				blockIndex = FindFreeBlock(searchSize);
+				if(blockIndex == invalidBlock)
+					blockIndex = FindFittingBlock(size, alignment);
+				if(blockIndex == invalidBlock)
+					return std::nullopt;
+			}
+
+			RemoveFreeBlock(blockIndex);
+
+			const UINT64 alignedOffset = (blocks[blockIndex].offset + alignment - 1) & ~(alignment - 1);
+			if(const UINT64 padding = alignedOffset - blocks[blockIndex].offset; padding > 0)
+			{
+				UINT32 paddingIndex = SplitFront(blockIndex, padding);
+				InsertFreeBlock(paddingIndex);
+			}
+
+			if(blocks[blockIndex].size > size)
+			{
+				UINT32 remainderIndex = SplitBack(blockIndex, size);
+				InsertFreeBlock(remainderIndex);
+			}
+
+			blocks[blockIndex].free = false;
+			freeSize -= size;
+			allocationCount++;
+			return Allocation{ blocks[blockIndex].offset, size, blockIndex };
+		}
+
+		void Free(const Allocation& allocation)
+		{
+			assert(allocation.IsValid());
+			assert(!blocks[allocation.block].free);
+
+			UINT32 blockIndex = allocation.block;
+			freeSize += blocks[blockIndex].size;
+			allocationCount--;
+
+			if(UINT32 previous = blocks[blockIndex].previousPhysical; previous != invalidBlock && blocks[previous].free)
+			{
+				RemoveFreeBlock(previous);
+				blockIndex = Merge(previous, blockIndex);
+			}
+
+			if(UINT32 next = blocks[blockIndex].nextPhysical; next != invalidBlock && blocks[next].free)
+			{
+				RemoveFreeBlock(next);
+				blockIndex = Merge(blockIndex, next);
+			}
+
+			InsertFreeBlock(blockIndex);
+		}
+
+	public:
+		UINT64 GetCapacity() const noexcept { return capacity; }
+		UINT64 GetFreeSize() const noexcept { return freeSize; }
+		UINT32 GetAllocationCount() const noexcept { return allocationCount; }
+		bool IsEmpty() const noexcept { return allocationCount == 0; }
+
+	private:
+		static Mapping MapSize(UINT64 size)
+		{
+			if(size < secondLevelCount)
+				return { 0, static_cast<UINT>(size) };
+
+			const UINT highestBit = static_cast<UINT>(std::bit_width(size)) - 1;
+			return
+			{
+				highestBit - secondLevelBits + 1,
+				static_cast<UINT>((size >> (highestBit - secondLevelBits)) ^ secondLevelCount)
+			};
+		}
+
+		//Rounds up to the next size class so that every block in the returned class is large enough
+		static Mapping MapSearchSize(UINT64 size)
+		{
+			if(size >= secondLevelCount)
+			{
+				const UINT highestBit = static_cast<UINT>(std::bit_width(size)) - 1;
+				const UINT64 round = (UINT64(1) << (highestBit - secondLevelBits)) - 1;
+				if(size + round > size)
+					size += round;
+			}
+			return MapSize(size);
+		}
+
+		bool Fits(UINT32 blockIndex, UINT64 size, UINT64 alignment) const
+		{
+			const Block& block = blocks[blockIndex];
+			const UINT64 alignedOffset = (block.offset + alignment - 1) & ~(alignment - 1);
+			return alignedOffset + size <= block.offset + block.size;
+		}
+
+		UINT32 FindFreeBlock(UINT64 size) const
+		{
+			Mapping mapping = MapSearchSize(size);
+			UINT32 secondLevelMap = secondLevelBitmaps[mapping.firstLevel] & (~0u << mapping.secondLevel);
+			if(secondLevelMap == 0)
+			{
+				if(mapping.firstLevel + 1 >= firstLevelCount)
+					return invalidBlock;
+
+				const UINT64 firstLevelMap = firstLevelBitmap & (~UINT64(0) << (mapping.firstLevel + 1));
+				if(firstLevelMap == 0)
+					return invalidBlock;
+
+				mapping.firstLevel = static_cast<UINT>(std::countr_zero(firstLevelMap));
+				secondLevelMap = secondLevelBitmaps[mapping.firstLevel];
+			}
+
+			mapping.secondLevel = static_cast<UINT>(std::countr_zero(secondLevelMap));
+			UINT32 blockIndex = freeLists[mapping.firstLevel][mapping.secondLevel];
+			return blocks[blockIndex].size >= size ? blockIndex : invalidBlock;
+		}
+
+		//The rounded up search skips the size classes between the request and the next class, which can still hold blocks large enough.
+		//Only reached when the rounded up search failed, so every class above the searched one is already known to be empty
+		UINT32 FindFittingBlock(UINT64 size, UINT64 alignment) const
+		{
+			const Mapping first = MapSize(size);
+			const Mapping last = MapSearchSize(size + alignment - 1);
+			for(UINT firstLevel = first.firstLevel; firstLevel <= last.firstLevel; firstLevel++)
+			{
+				UINT32 secondLevelMap = secondLevelBitmaps[firstLevel];
+				if(firstLevel == first.firstLevel)
+					secondLevelMap &= ~0u << first.secondLevel;
+				if(firstLevel == last.firstLevel)
+					secondLevelMap &= ~0u >> (secondLevelCount - 1 - last.secondLevel);
+
+				for(; secondLevelMap != 0; secondLevelMap &= secondLevelMap - 1)
+				{
+					const UINT secondLevel = static_cast<UINT>(std::countr_zero(secondLevelMap));
+					for(UINT32 blockIndex = freeLists[firstLevel][secondLevel]; blockIndex != invalidBlock; blockIndex = blocks[blockIndex].nextFree)
+					{
+						if(Fits(blockIndex, size, alignment))
+							return blockIndex;
+					}
+				}
+			}
+			return invalidBlock;
+		}
+
+		void InsertFreeBlock(UINT32 blockIndex)
+		{
+			Block& block = blocks[blockIndex];
+			const Mapping mapping = MapSize(block.size);
+			UINT32& head = freeLists[mapping.firstLevel][mapping.secondLevel];
+
+			block.free = true;
+			block.previousFree = invalidBlock;
+			block.nextFree = head;
+			if(head != invalidBlock)
+				blocks[head].previousFree = blockIndex;
+			head = blockIndex;
+
+			firstLevelBitmap |= UINT64(1) << mapping.firstLevel;
+			secondLevelBitmaps[mapping.firstLevel] |= 1u << mapping.secondLevel;
+		}
+
+		void RemoveFreeBlock(UINT32 blockIndex)
+		{
+			Block& block = blocks[blockIndex];
+			const Mapping mapping = MapSize(block.size);
+			UINT32& head = freeLists[mapping.firstLevel][mapping.secondLevel];
+
+			if(block.previousFree != invalidBlock)
+				blocks[block.previousFree].nextFree = block.nextFree;
+			if(block.nextFree != invalidBlock)
+				blocks[block.nextFree].previousFree = block.previousFree;
+
+			if(head == blockIndex)
+			{
+				head = block.nextFree;
+				if(head == invalidBlock)
+				{
+					secondLevelBitmaps[mapping.firstLevel] &= ~(1u << mapping.secondLevel);
+					if(secondLevelBitmaps[mapping.firstLevel] == 0)
+						firstLevelBitmap &= ~(UINT64(1) << mapping.firstLevel);
+				}
+			}
+
+			block.free = false;
+			block.previousFree = invalidBlock;
+			block.nextFree = invalidBlock;
+		}
+
+		//Splits off the first size bytes of the block into a new block which is returned
+		UINT32 SplitFront(UINT32 blockIndex, UINT64 size)
+		{
+			UINT32 frontIndex = NewBlock({ .offset = blocks[blockIndex].offset, .size = size, .previousPhysical = blocks[blockIndex].previousPhysical, .nextPhysical = blockIndex });
+			if(blocks[frontIndex].previousPhysical != invalidBlock)
+				blocks[blocks[frontIndex].previousPhysical].nextPhysical = frontIndex;
+
+			blocks[blockIndex].previousPhysical = frontIndex;
+			blocks[blockIndex].offset += size;
+			blocks[blockIndex].size -= size;
+			return frontIndex;
+		}
+
+		//Keeps the first size bytes in the block and returns a new block holding the rest
+		UINT32 SplitBack(UINT32 blockIndex, UINT64 size)
+		{
+			UINT32 backIndex = NewBlock({ .offset = blocks[blockIndex].offset + size, .size = blocks[blockIndex].size - size, .previousPhysical = blockIndex, .nextPhysical = blocks[blockIndex].nextPhysical });
+			if(blocks[backIndex].nextPhysical != invalidBlock)
+				blocks[blocks[backIndex].nextPhysical].previousPhysical = backIndex;
+
+			blocks[blockIndex].nextPhysical = backIndex;
+			blocks[blockIndex].size = size;
+			return backIndex;
+		}
+
+		//Merges 2 physically adjacent blocks, returning the surviving block
+		UINT32 Merge(UINT32 frontIndex, UINT32 backIndex)
+		{
+			assert(blocks[frontIndex].nextPhysical == backIndex);
+			blocks[frontIndex].size += blocks[backIndex].size;
+			blocks[frontIndex].nextPhysical = blocks[backIndex].nextPhysical;
+			if(blocks[frontIndex].nextPhysical != invalidBlock)
+				blocks[blocks[frontIndex].nextPhysical].previousPhysical = frontIndex;
+
+			blocks[backIndex] = {};
+			unusedBlocks.push_back(backIndex);
+			return frontIndex;
+		}
+
+		UINT32 NewBlock(const Block& block)
+		{
+			if(!unusedBlocks.empty())
+			{
+				UINT32 index = unusedBlocks.back();
+				unusedBlocks.pop_back();
+				blocks[index] = block;
+				return index;
+			}
+
+			blocks.push_back(block);
+			return static_cast<UINT32>(blocks.size() - 1);
+		}
+	};
+}
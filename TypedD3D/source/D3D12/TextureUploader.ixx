@@ -0,0 +1,313 @@
+module;
+
+#include <d3d12.h>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <gsl/pointers>
+
+export module TypedD3D12:TextureUploader;
+import TypedD3D.Shared;
+import :Wrappers;
+import :Device;
+import :CommandList;
+import :CommandQueue;
+import :CommandAllocator;
+import :Resource;
+
+namespace TypedD3D::D3D12
+{
+	/// <summary>
+	/// Streams texture data through a fixed size staging buffer on a copy queue.
+	/// Subresources are split by depth slice and row range so that no chunk is larger than the staging budget,
+	/// staging memory stays bounded no matter how large the texture is.
+	/// Every batch of copies signals the uploader's fence, other queues Wait on the value returned by Upload once it has been Flushed.
+	/// Destination resources must be in the COMMON state, they're implicitly promoted to COPY_DEST and decay back once the copy completes.
+	/// Not thread safe
+	/// </summary>
+	export class TextureUploader
+	{
+	public:
+		static constexpr UINT64 defaultStagingSize = 32 * 1024 * 1024;
+
+	private:
+		struct InFlightBatch
+		{
+			UINT64 fenceValue;
+			UINT64 stagingEnd;
+			Copy<ID3D12CommandAllocator> allocator;
+		};
+
+		Wrapper<ID3D12Device> device;
+		Copy<ID3D12CommandQueue> queue;
+		Copy<ID3D12GraphicsCommandList> commandList;
+		Copy<ID3D12CommandAllocator> currentAllocator;
+		Wrapper<ID3D12Fence> fence;
+		UINT64 fenceValue = 0;
+		bool batchOpen = false;
+
+		Wrapper<ID3D12Resource> staging;
+		std::byte* stagingAddress = nullptr;
+		UINT64 stagingSize = 0;
+
+		//Monotonic byte positions, the offset within the staging buffer is the position modulo stagingSize
+		UINT64 stagingHead = 0;
+		UINT64 stagingTail = 0;
+
+		std::deque<InFlightBatch> inFlightBatches;
+		std::vector<Copy<ID3D12CommandAllocator>> freeAllocators;
+
+	public:
+		TextureUploader(Wrapper<ID3D12Device> device, Copy<ID3D12CommandQueue> queue, UINT64 stagingSize = defaultStagingSize) :
+			device{ std::move(device) },
+			queue{ std::move(queue) },
+			stagingSize{ AlignUp(stagingSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT) }
+		{
+			fence = this->device->CreateFence(0, D3D12_FENCE_FLAG_NONE);
+
+			currentAllocator = this->device->CreateCommandAllocator<D3D12_COMMAND_LIST_TYPE_COPY>();
+			commandList = this->device->CreateCommandList<D3D12_COMMAND_LIST_TYPE_COPY>(currentAllocator);
+			commandList->Close();
+			freeAllocators.push_back(std::move(currentAllocator));
+
+			D3D12_HEAP_PROPERTIES heapProperties
+			{
+				.Type = D3D12_HEAP_TYPE_UPLOAD,
+				.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
+				.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN
+			};
+
+			D3D12_RESOURCE_DESC desc
+			{
+				.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+				.Alignment = 0,
+				.Width = this->stagingSize,
+				.Height = 1,
+				.DepthOrArraySize = 1,
+				.MipLevels = 1,
+				.Format = DXGI_FORMAT_UNKNOWN,
+				.SampleDesc = { 1, 0 },
+				.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+				.Flags = D3D12_RESOURCE_FLAG_NONE
+			};
+
+			staging = this->device->CreateCommittedResource(heapProperties, D3D12_HEAP_FLAG_NONE, desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr);
+
+			D3D12_RANGE readRange{ 0, 0 };
+			stagingAddress = staging->Map(0, &readRange);
+		}
+
+		TextureUploader(const TextureUploader&) = delete;
+		TextureUploader& operator=(const TextureUploader&) = delete;
+
+		~TextureUploader()
+		{
+			//Flush and WaitForIdle only fail once the device is lost, and then the GPU no longer reads the staging buffer
+			try
+			{
+				if(batchOpen)
+					Flush();
+				WaitForIdle();
+			}
+			catch(...)
+			{
+			}
+		}
+
+	public:
+		/// <summary>
+		/// Records copies of subresources into destination starting at firstSubresource.
+		/// May submit and wait for earlier batches when the staging buffer is full.
+		/// Returns the fence value which is signaled once every copy of this call has completed
+		/// </summary>
+		UINT64 Upload(gsl::not_null<WrapperView<ID3D12Resource>> destination, UINT firstSubresource, std::span<const D3D12_SUBRESOURCE_DATA> subresources)
+		{
+			D3D12_RESOURCE_DESC desc = destination->GetDesc();
+			if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+				throw std::invalid_argument("TextureUploader only uploads textures");
+
+			const UINT subresourceCount = static_cast<UINT>(subresources.size());
+			std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresourceCount);
+			std::vector<UINT> numRows(subresourceCount);
+			std::vector<UINT64> rowSizes(subresourceCount);
+			device->GetCopyableFootprints(desc, firstSubresource, subresourceCount, 0, layouts.data(), numRows.data(), rowSizes.data(), nullptr);
+
+			for(UINT i = 0; i < subresourceCount; i++)
+			{
+				const D3D12_SUBRESOURCE_FOOTPRINT& footprint = layouts[i].Footprint;
+				const D3D12_SUBRESOURCE_DATA& source = subresources[i];
+				if(numRows[i] == 0)
+					continue;
+
+				//Block compressed formats copy a row of blocks per row
+				const UINT rowHeight = footprint.Height / numRows[i];
+				const UINT64 maxRowsPerChunk = stagingSize / footprint.RowPitch;
+				if(maxRowsPerChunk == 0)
+					throw std::invalid_argument("A single row of the texture doesn't fit in the staging budget");
+
+				D3D12_TEXTURE_COPY_LOCATION destinationLocation{};
+				destinationLocation.pResource = destination.get().Get();
+				destinationLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+				destinationLocation.SubresourceIndex = firstSubresource + i;
+
+				for(UINT slice = 0; slice < footprint.Depth; slice++)
+				{
+					for(UINT row = 0; row < numRows[i];)
+					{
+						const UINT rows = static_cast<UINT>(std::min<UINT64>(numRows[i] - row, maxRowsPerChunk));
+						const UINT64 stagingOffset = AllocateStaging(static_cast<UINT64>(rows) * footprint.RowPitch);
+
+						const std::byte* sourceRows = static_cast<const std::byte*>(source.pData) + slice * source.SlicePitch + static_cast<LONG_PTR>(row) * source.RowPitch;
+						for(UINT r = 0; r < rows; r++)
+							std::memcpy(stagingAddress + stagingOffset + static_cast<UINT64>(r) * footprint.RowPitch, sourceRows + static_cast<LONG_PTR>(r) * source.RowPitch, rowSizes[i]);
+
+						D3D12_TEXTURE_COPY_LOCATION stagingLocation{};
+						stagingLocation.pResource = staging.Get();
+						stagingLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+						stagingLocation.PlacedFootprint =
+						{
+							.Offset = stagingOffset,
+							.Footprint =
+							{
+								.Format = footprint.Format,
+								.Width = footprint.Width,
+								.Height = std::min(rows * rowHeight, footprint.Height - row * rowHeight),
+								.Depth = 1,
+								.RowPitch = footprint.RowPitch
+							}
+						};
+
+						commandList->CopyTextureRegion(destinationLocation, 0, row * rowHeight, slice, stagingLocation, nullptr);
+						row += rows;
+					}
+				}
+			}
+
+			return batchOpen ? fenceValue + 1 : fenceValue;
+		}
+
+		/// <summary>
+		/// Submits the open batch, if any. Returns the fence value signaled by the last submitted batch
+		/// </summary>
+		UINT64 Flush()
+		{
+			if(!batchOpen)
+				return fenceValue;
+
+			ThrowIfFailed(commandList->Close());
+			Array<CopyView<ID3D12CommandList>, 1> submitList{ commandList };
+			queue->ExecuteCommandLists(Span(submitList));
+
+			fenceValue++;
+			ThrowIfFailed(queue->Signal(fence, fenceValue));
+			inFlightBatches.push_back({ fenceValue, stagingHead, std::move(currentAllocator) });
+			batchOpen = false;
+			return fenceValue;
+		}
+
+		void WaitForIdle()
+		{
+			WaitForFenceValue(fenceValue);
+			Reclaim();
+		}
+
+		/// <summary>
+		/// Makes the given queue wait on the GPU until every copy recorded so far has completed. Flushes the open batch
+		/// </summary>
+		template<class QueueTy>
+		void QueueWait(QueueTy& otherQueue)
+		{
+			ThrowIfFailed(otherQueue->Wait(fence, Flush()));
+		}
+
+	public:
+		WrapperView<ID3D12Fence> GetFence() const noexcept { return fence; }
+		UINT64 GetLastSignaledValue() const noexcept { return fenceValue; }
+		UINT64 GetStagingSize() const noexcept { return stagingSize; }
+
+	private:
+		UINT64 AllocateStaging(UINT64 size)
+		{
+			assert(size <= stagingSize);
+			while(true)
+			{
+				UINT64 position = AlignUp(stagingHead, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+				if(position % stagingSize + size > stagingSize)
+					position = (position / stagingSize + 1) * stagingSize;
+
+				if(position + size - stagingTail <= stagingSize)
+				{
+					BeginBatch();
+					stagingHead = position + size;
+					return position % stagingSize;
+				}
+
+				if(!inFlightBatches.empty() && inFlightBatches.front().fenceValue <= fence->GetCompletedValue())
+				{
+					Reclaim();
+				}
+				else if(batchOpen)
+				{
+					Flush();
+				}
+				else if(!inFlightBatches.empty())
+				{
+					WaitForFenceValue(inFlightBatches.front().fenceValue);
+					Reclaim();
+				}
+				else
+				{
+					//Nothing is using the staging buffer, restart at the beginning
+					stagingHead = stagingTail = (stagingHead / stagingSize + 1) * stagingSize;
+				}
+			}
+		}
+
+		void BeginBatch()
+		{
+			if(batchOpen)
+				return;
+
+			Reclaim();
+			if(freeAllocators.empty())
+			{
+				currentAllocator = device->CreateCommandAllocator<D3D12_COMMAND_LIST_TYPE_COPY>();
+			}
+			else
+			{
+				currentAllocator = std::move(freeAllocators.back());
+				freeAllocators.pop_back();
+				ThrowIfFailed(currentAllocator->Reset());
+			}
+
+			ThrowIfFailed(commandList->Reset(currentAllocator, nullptr));
+			batchOpen = true;
+		}
+
+		void Reclaim()
+		{
+			const UINT64 completedValue = fence->GetCompletedValue();
+			while(!inFlightBatches.empty() && inFlightBatches.front().fenceValue <= completedValue)
+			{
+				stagingTail = inFlightBatches.front().stagingEnd;
+				freeAllocators.push_back(std::move(inFlightBatches.front().allocator));
+				inFlightBatches.pop_front();
+			}
+		}
+
+		void WaitForFenceValue(UINT64 value)
+		{
+			if(fence->GetCompletedValue() >= value)
+				return;
+
+			//A null event blocks until the fence reaches the value
+			ThrowIfFailed(fence->SetEventOnCompletion(value, nullptr));
+		}
+	};
+}
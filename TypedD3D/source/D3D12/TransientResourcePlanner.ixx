@@ -0,0 +1,264 @@
+module;
+
+#include <d3d12.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include <gsl/pointers>
+
+export module TypedD3D12:TransientResourcePlanner;
+import TypedD3D.Shared;
+import TypedD3D.Legacy.D3D12Helpers;
+import :Device;
+import :Resource;
+import :PlacedResourceAllocator;
+
+namespace TypedD3D::D3D12
+{
+	/// <summary>
+	/// The memory requirements of a transient resource and the inclusive range of passes it is used in
+	/// </summary>
+	export struct TransientLifetime
+	{
+		D3D12_RESOURCE_ALLOCATION_INFO allocationInfo;
+		HeapCategory category = HeapCategory::Universal;
+		UINT firstUse = 0;
+		UINT lastUse = 0;
+	};
+
+	export struct TransientAliasing
+	{
+		static constexpr UINT noResource = UINT_MAX;
+
+		UINT pass;
+
+		//Index of the resource which last used the memory, noResource when several resources did
+		UINT before;
+		UINT after;
+	};
+
+	export struct TransientAliasingPlan
+	{
+		//Offset of every lifetime inside the heap of its category
+		std::vector<UINT64> offsets;
+		std::array<UINT64, static_cast<size_t>(HeapCategory::Count)> heapSizes = {};
+
+		//Sorted by pass
+		std::vector<TransientAliasing> aliasing;
+
+		//Memory the resources would use if none of them were aliased
+		UINT64 unaliasedSize = 0;
+
+		UINT64 GetAliasedSize() const noexcept { return std::accumulate(heapSizes.begin(), heapSizes.end(), UINT64(0)); }
+	};
+
+	/// <summary>
+	/// Packs resources whose lifetimes don't overlap into the same heap ranges.
+	/// Resources are placed largest first at the lowest offset that doesn't collide with a resource alive at the same time.
+	/// Every resource sharing memory with another gets an aliasing barrier on its first use
+	/// </summary>
+	export TransientAliasingPlan PlanTransientAliasing(std::span<const TransientLifetime> lifetimes)
+	{
+		constexpr UINT unplaced = UINT_MAX;
+
+		TransientAliasingPlan plan;
+		plan.offsets.resize(lifetimes.size());
+
+		auto LifetimesOverlap = [&](size_t lh, size_t rh)
+		{
+			return lifetimes[lh].firstUse <= lifetimes[rh].lastUse && lifetimes[rh].firstUse <= lifetimes[lh].lastUse;
+		};
+
+		auto MemoryOverlaps = [&](size_t lh, size_t rh)
+		{
+			return lifetimes[lh].category == lifetimes[rh].category
+				&& plan.offsets[lh] < plan.offsets[rh] + lifetimes[rh].allocationInfo.SizeInBytes
+				&& plan.offsets[rh] < plan.offsets[lh] + lifetimes[lh].allocationInfo.SizeInBytes;
+		};
+
+		std::vector<UINT> order(lifetimes.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::ranges::stable_sort(order, [&](UINT lh, UINT rh) { return lifetimes[lh].allocationInfo.SizeInBytes > lifetimes[rh].allocationInfo.SizeInBytes; });
+
+		std::vector<UINT> placed;
+		std::vector<std::pair<UINT64, UINT64>> occupied;
+		for(UINT index : order)
+		{
+			const TransientLifetime& lifetime = lifetimes[index];
+			if(lifetime.firstUse > lifetime.lastUse)
+				throw std::invalid_argument("Transient resource is last used before its first use");
+
+			plan.unaliasedSize += AlignUp(lifetime.allocationInfo.SizeInBytes, lifetime.allocationInfo.Alignment);
+
+			occupied.clear();
+			for(UINT other : placed)
+			{
+				if(lifetimes[other].category == lifetime.category && LifetimesOverlap(index, other))
+					occupied.emplace_back(plan.offsets[other], plan.offsets[other] + lifetimes[other].allocationInfo.SizeInBytes);
+			}
+			std::ranges::sort(occupied);
+
+			UINT64 offset = 0;
+			for(auto [begin, end] : occupied)
+			{
+				if(offset + lifetime.allocationInfo.SizeInBytes <= begin)
+					break;
+				offset = std::max(offset, AlignUp(end, lifetime.allocationInfo.Alignment));
+			}
+
+			plan.offsets[index] = offset;
+			UINT64& heapSize = plan.heapSizes[static_cast<size_t>(lifetime.category)];
+			heapSize = std::max(heapSize, offset + lifetime.allocationInfo.SizeInBytes);
+			placed.push_back(index);
+		}
+
+		for(UINT after = 0; after < lifetimes.size(); after++)
+		{
+			UINT before = unplaced;
+			UINT overlapCount = 0;
+			bool aliased = false;
+			for(UINT other = 0; other < lifetimes.size(); other++)
+			{
+				if(other == after || !MemoryOverlaps(after, other))
+					continue;
+
+				aliased = true;
+				if(lifetimes[other].lastUse < lifetimes[after].firstUse)
+				{
+					//Only the resources which used the memory last before this one are relevant
+					if(before == unplaced || lifetimes[other].lastUse > lifetimes[before].lastUse)
+					{
+						before = other;
+						overlapCount = 1;
+					}
+					else if(lifetimes[other].lastUse == lifetimes[before].lastUse)
+					{
+						overlapCount++;
+					}
+				}
+			}
+
+			if(!aliased)
+				continue;
+
+			plan.aliasing.push_back(
+				{
+					.pass = lifetimes[after].firstUse,
+					.before = (before == unplaced || overlapCount > 1) ? TransientAliasing::noResource : before,
+					.after = after
+				});
+		}
+
+		std::ranges::stable_sort(plan.aliasing, {}, &TransientAliasing::pass);
+		return plan;
+	}
+
+	export struct TransientResourceDesc
+	{
+		D3D12_RESOURCE_DESC desc;
+		D3D12_RESOURCE_STATES initialState;
+		std::optional<D3D12_CLEAR_VALUE> optimizedClearValue;
+		UINT firstUse = 0;
+		UINT lastUse = 0;
+	};
+
+	/// <summary>
+	/// Creates the resources of a frame's transient resource descriptions inside shared heaps following a TransientAliasingPlan.
+	/// Call RecordAliasingBarriers at the start of every pass, resources being activated must then be fully initialized
+	/// with a clear, discard or copy before they are read
+	/// </summary>
+	export class TransientResourcePool
+	{
+		TransientAliasingPlan plan;
+		std::array<Wrapper<ID3D12Heap>, static_cast<size_t>(HeapCategory::Count)> heaps;
+		std::vector<Wrapper<ID3D12Resource>> resources;
+		std::vector<D3D12_RESOURCE_BARRIER> barriers;
+		std::vector<UINT> passBarrierStart;
+
+	public:
+		TransientResourcePool() = default;
+		TransientResourcePool(gsl::not_null<WrapperView<ID3D12Device>> device, std::span<const TransientResourceDesc> descs, UINT nodeMask = 0)
+		{
+			const D3D12_RESOURCE_HEAP_TIER tier = device->CheckFeatureSupport<D3D12_FEATURE_D3D12_OPTIONS>().ResourceHeapTier;
+
+			std::vector<TransientLifetime> lifetimes;
+			lifetimes.reserve(descs.size());
+			for(const TransientResourceDesc& desc : descs)
+			{
+				D3D12_RESOURCE_DESC resourceDesc = desc.desc;
+				lifetimes.push_back(
+					{
+						.allocationInfo = device->GetResourceAllocationInfo(nodeMask, std::span(&resourceDesc, 1)),
+						.category = GetHeapCategory(desc.desc, tier),
+						.firstUse = desc.firstUse,
+						.lastUse = desc.lastUse
+					});
+			}
+
+			plan = PlanTransientAliasing(lifetimes);
+
+			for(size_t category = 0; category < heaps.size(); category++)
+			{
+				if(plan.heapSizes[category] == 0)
+					continue;
+
+				D3D12_HEAP_DESC heapDesc
+				{
+					.SizeInBytes = AlignUp(plan.heapSizes[category], D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT),
+					.Properties = { .Type = D3D12_HEAP_TYPE_DEFAULT, .CreationNodeMask = nodeMask, .VisibleNodeMask = nodeMask },
+					.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT,
+					.Flags = GetHeapCategoryFlags(static_cast<HeapCategory>(category))
+				};
+				heaps[category] = device->CreateHeap(heapDesc);
+			}
+
+			resources.reserve(descs.size());
+			for(size_t i = 0; i < descs.size(); i++)
+			{
+				resources.push_back(device->CreatePlacedResource(
+					heaps[static_cast<size_t>(lifetimes[i].category)],
+					plan.offsets[i],
+					descs[i].desc,
+					descs[i].initialState,
+					descs[i].optimizedClearValue ? &*descs[i].optimizedClearValue : nullptr));
+			}
+
+			const UINT passCount = descs.empty() ? 0 : std::ranges::max(descs, {}, &TransientResourceDesc::lastUse).lastUse + 1;
+			passBarrierStart.assign(passCount + 1, 0);
+			barriers.reserve(plan.aliasing.size());
+			for(const TransientAliasing& aliasing : plan.aliasing)
+			{
+				ID3D12Resource* before = aliasing.before == TransientAliasing::noResource ? nullptr : resources[aliasing.before].Get();
+				barriers.push_back(Helpers::D3D12::AliasingBarrier(before, resources[aliasing.after].Get()));
+				passBarrierStart[aliasing.pass + 1]++;
+			}
+			std::partial_sum(passBarrierStart.begin(), passBarrierStart.end(), passBarrierStart.begin());
+		}
+
+	public:
+		WrapperView<ID3D12Resource> GetResource(UINT index) const { return resources[index]; }
+
+		std::span<const D3D12_RESOURCE_BARRIER> GetAliasingBarriers(UINT pass) const
+		{
+			if(pass + 1 >= passBarrierStart.size())
+				return {};
+			return std::span(barriers).subspan(passBarrierStart[pass], passBarrierStart[pass + 1] - passBarrierStart[pass]);
+		}
+
+		template<class CommandListTy>
+		void RecordAliasingBarriers(CommandListTy& commandList, UINT pass) const
+		{
+			std::span<const D3D12_RESOURCE_BARRIER> passBarriers = GetAliasingBarriers(pass);
+			if(!passBarriers.empty())
+				commandList->ResourceBarrier(passBarriers);
+		}
+
+		const TransientAliasingPlan& GetPlan() const noexcept { return plan; }
+	};
+}
@@ -0,0 +1,307 @@
+module;
+
+#include <d3d12.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <gsl/pointers>
+
+export module TypedD3D12:UploadRingAllocator;
+import TypedD3D.Shared;
+import :Device;
+import :Resource;
+
+namespace TypedD3D::D3D12
+{
+	export struct UploadAllocation
+	{
+		std::byte* cpuAddress = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+		UINT64 size = 0;
+
+		//The upload buffer and the offset of the allocation within it, for use with CopyBufferRegion and CopyTextureRegion
+		WrapperView<ID3D12Resource> resource;
+		UINT64 offset = 0;
+	};
+
+	/// <summary>
+	/// A thread safe allocator over persistently mapped UPLOAD heap buffers.
+	/// Pages are split into fixed size blocks which are handed out to ThreadContexts, so allocating from a context is a
+	/// pointer bump with no locks. A new page is chained in whenever no free block is left.
+	/// Blocks handed out are only reused once the fence value they were retired with has completed.
+	/// </summary>
+	export class UploadRingAllocator
+	{
+	public:
+		static constexpr UINT64 defaultPageSize = 2 * 1024 * 1024;
+		static constexpr UINT64 defaultBlockSize = 64 * 1024;
+		static constexpr UINT64 defaultAlignment = 16;
+
+	private:
+		struct Page
+		{
+			Wrapper<ID3D12Resource> resource;
+			std::byte* cpuAddress = nullptr;
+			D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+			bool dedicated = false;
+		};
+
+		struct Block
+		{
+			Page* page = nullptr;
+			UINT64 offset = 0;
+			UINT64 size = 0;
+
+			//The number of Retire calls made before the block was handed out
+			UINT64 generation = 0;
+
+			UploadAllocation Suballocate(UINT64 blockOffset, UINT64 allocationSize) const
+			{
+				return
+				{
+					.cpuAddress = page->cpuAddress + offset + blockOffset,
+					.gpuAddress = page->gpuAddress + offset + blockOffset,
+					.size = allocationSize,
+					.resource = page->resource,
+					.offset = offset + blockOffset
+				};
+			}
+		};
+
+		struct RetiredBlocks
+		{
+			UINT64 fenceValue;
+			std::vector<Block> blocks;
+		};
+
+	public:
+		/// <summary>
+		/// Allocates out of a single block at a time, only going back to the owning allocator once the block is full.
+		/// A block handed out before the last Retire is dropped on the next allocation, so allocations never land in a block retired with an older fence value.
+		/// A context must only be used by one thread at a time, and not while the allocator is being Retired
+		/// </summary>
+		class ThreadContext
+		{
+			UploadRingAllocator* allocator = nullptr;
+			Block block;
+			UINT64 used = 0;
+
+		public:
+			ThreadContext() = default;
+			ThreadContext(UploadRingAllocator& allocator) :
+				allocator{ &allocator }
+			{
+			}
+
+			ThreadContext(const ThreadContext&) = delete;
+			ThreadContext(ThreadContext&& other) noexcept :
+				allocator{ std::exchange(other.allocator, nullptr) },
+				block{ std::exchange(other.block, {}) },
+				used{ std::exchange(other.used, 0) }
+			{
+			}
+
+			ThreadContext& operator=(const ThreadContext&) = delete;
+			ThreadContext& operator=(ThreadContext&& other) noexcept
+			{
+				allocator = std::exchange(other.allocator, nullptr);
+				block = std::exchange(other.block, {});
+				used = std::exchange(other.used, 0);
+				return *this;
+			}
+
+		public:
+			UploadAllocation Allocate(UINT64 size, UINT64 alignment = defaultAlignment)
+			{
+				assert(allocator);
+				assert(std::has_single_bit(alignment));
+
+				UINT64 offset = AlignUp(used, alignment);
+				if(block.page == nullptr || offset + size > block.size || block.generation != allocator->retireCount.load(std::memory_order_relaxed))
+				{
+					if(AlignUp(size, alignment) > allocator->blockSize || alignment > allocator->blockSize)
+						return allocator->AllocateDedicated(size, alignment);
+
+					block = allocator->AcquireBlock();
+					offset = 0;
+				}
+
+				used = offset + size;
+				return block.Suballocate(offset, size);
+			}
+
+			/// <summary>
+			/// Stops allocating out of the current block. The rest of the block is reclaimed along with the allocations made from it
+			/// </summary>
+			void Reset()
+			{
+				block = {};
+				used = 0;
+			}
+		};
+
+	private:
+		Wrapper<ID3D12Device> device;
+		UINT64 pageSize = defaultPageSize;
+		UINT64 blockSize = defaultBlockSize;
+
+		std::mutex mutex;
+		std::mutex sharedAllocationMutex;
+		std::vector<std::unique_ptr<Page>> pages;
+		std::vector<Block> freeBlocks;
+		std::vector<Block> pendingBlocks;
+		std::deque<RetiredBlocks> retiredBlocks;
+		std::atomic<UINT64> retireCount = 0;
+		ThreadContext sharedContext;
+
+	public:
+		UploadRingAllocator(Wrapper<ID3D12Device> device, UINT64 pageSize = defaultPageSize, UINT64 blockSize = defaultBlockSize) :
+			device{ std::move(device) },
+			pageSize{ AlignUp(pageSize, blockSize) },
+			blockSize{ blockSize },
+			sharedContext{ *this }
+		{
+			assert(std::has_single_bit(blockSize));
+		}
+
+		UploadRingAllocator(const UploadRingAllocator&) = delete;
+		UploadRingAllocator(UploadRingAllocator&&) = delete;
+
+		UploadRingAllocator& operator=(const UploadRingAllocator&) = delete;
+		UploadRingAllocator& operator=(UploadRingAllocator&&) = delete;
+
+	public:
+		ThreadContext CreateContext() { return { *this }; }
+
+		/// <summary>
+		/// Allocates without a ThreadContext. Takes a lock per call, prefer a ThreadContext on hot paths
+		/// </summary>
+		UploadAllocation Allocate(UINT64 size, UINT64 alignment = defaultAlignment)
+		{
+			std::scoped_lock lock{ sharedAllocationMutex };
+			return sharedContext.Allocate(size, alignment);
+		}
+
+		/// <summary>
+		/// Marks every block handed out since the last call as in use by the GPU until fenceValue has completed.
+		/// Contexts stop allocating out of those blocks
+		/// </summary>
+		void Retire(UINT64 fenceValue)
+		{
+			std::scoped_lock lock{ mutex };
+			retireCount.fetch_add(1, std::memory_order_relaxed);
+			if(pendingBlocks.empty())
+				return;
+
+			assert(retiredBlocks.empty() || retiredBlocks.back().fenceValue <= fenceValue);
+			retiredBlocks.push_back({ fenceValue, std::move(pendingBlocks) });
+			pendingBlocks.clear();
+		}
+
+		/// <summary>
+		/// Makes blocks retired with a fence value up to and including completedFenceValue available again
+		/// </summary>
+		void Reclaim(UINT64 completedFenceValue)
+		{
+			std::scoped_lock lock{ mutex };
+			while(!retiredBlocks.empty() && retiredBlocks.front().fenceValue <= completedFenceValue)
+			{
+				for(Block& block : retiredBlocks.front().blocks)
+				{
+					if(block.page->dedicated)
+						std::erase_if(pages, [page = block.page](const std::unique_ptr<Page>& p) { return p.get() == page; });
+					else
+						freeBlocks.push_back(block);
+				}
+				retiredBlocks.pop_front();
+			}
+		}
+
+		void Reclaim(gsl::not_null<WrapperView<ID3D12Fence>> fence)
+		{
+			Reclaim(fence->GetCompletedValue());
+		}
+
+	public:
+		UINT64 GetPageSize() const noexcept { return pageSize; }
+		UINT64 GetBlockSize() const noexcept { return blockSize; }
+
+		size_t GetPageCount()
+		{
+			std::scoped_lock lock{ mutex };
+			return pages.size();
+		}
+
+	private:
+		Block AcquireBlock()
+		{
+			std::scoped_lock lock{ mutex };
+			if(freeBlocks.empty())
+			{
+				Page& page = CreatePage(pageSize, false);
+				for(UINT64 offset = pageSize; offset > 0; offset -= blockSize)
+					freeBlocks.push_back({ &page, offset - blockSize, blockSize });
+			}
+
+			Block block = freeBlocks.back();
+			freeBlocks.pop_back();
+			block.generation = retireCount.load(std::memory_order_relaxed);
+			pendingBlocks.push_back(block);
+			return block;
+		}
+
+		UploadAllocation AllocateDedicated(UINT64 size, UINT64 alignment)
+		{
+			std::scoped_lock lock{ mutex };
+
+			//Buffers are always 64KB aligned, any smaller alignment is satisfied by the start of the page
+			assert(alignment <= D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+			Page& page = CreatePage(AlignUp(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT), true);
+			Block block{ &page, 0, size };
+			pendingBlocks.push_back(block);
+			return block.Suballocate(0, size);
+		}
+
+		Page& CreatePage(UINT64 size, bool dedicated)
+		{
+			D3D12_HEAP_PROPERTIES heapProperties
+			{
+				.Type = D3D12_HEAP_TYPE_UPLOAD,
+				.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
+				.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN
+			};
+
+			D3D12_RESOURCE_DESC desc
+			{
+				.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+				.Alignment = 0,
+				.Width = size,
+				.Height = 1,
+				.DepthOrArraySize = 1,
+				.MipLevels = 1,
+				.Format = DXGI_FORMAT_UNKNOWN,
+				.SampleDesc = { 1, 0 },
+				.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+				.Flags = D3D12_RESOURCE_FLAG_NONE
+			};
+
+			auto page = std::make_unique<Page>();
+			page->resource = device->CreateCommittedResource(heapProperties, D3D12_HEAP_FLAG_NONE, desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr);
+
+			//Upload heaps are never read by the CPU, and stay mapped for the lifetime of the page
+			D3D12_RANGE readRange{ 0, 0 };
+			page->cpuAddress = page->resource->Map(0, &readRange);
+			page->gpuAddress = page->resource->GetGPUVirtualAddress();
+			page->dedicated = dedicated;
+
+			return *pages.emplace_back(std::move(page));
+		}
+	};
+}
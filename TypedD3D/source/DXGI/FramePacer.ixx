@@ -0,0 +1,274 @@
+module;
+
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <gsl/pointers>
+
+export module TypedDXGI:FramePacer;
+import TypedD3D.Shared;
+import TypedD3D.Legacy.D3D12Helpers;
+import TypedD3D12;
+import :SwapChain;
+
+namespace TypedD3D::DXGI
+{
+	export struct FramePacingStatistics
+	{
+		UINT64 framesPresented = 0;
+
+		//Time from the start of a frame's CPU work until it was scanned out, only measured for frames the statistics could be matched to
+		double lastLatencyMilliseconds = 0;
+		double averageLatencyMilliseconds = 0;
+
+		//Presents queued but not yet displayed as of the last EndFrame
+		UINT queuedPresents = 0;
+
+		//Times BeginFrame gave up waiting on the frame latency waitable object after a second
+		UINT64 frameLatencyTimeouts = 0;
+	};
+
+	/// <summary>
+	/// Backend of BasicFramePacer which paces a D3D12 queue presenting to a DXGI swap chain
+	/// </summary>
+	export class DXGIFramePacingBackend
+	{
+		Wrapper<IDXGISwapChain3> swapChain;
+		Direct<ID3D12CommandQueue> queue;
+		Wrapper<ID3D12Fence> fence;
+		HANDLE frameLatencyWaitable = nullptr;
+		Helpers::D3D12::AdaptiveFenceWaiter fenceWaiter;
+		LARGE_INTEGER qpcFrequency{};
+
+	public:
+		DXGIFramePacingBackend(Wrapper<IDXGISwapChain3> swapChain, Direct<ID3D12CommandQueue> queue, gsl::not_null<WrapperView<ID3D12Device>> device) :
+			swapChain{ std::move(swapChain) },
+			queue{ std::move(queue) }
+		{
+			fence = device->CreateFence(0, D3D12_FENCE_FLAG_NONE);
+			frameLatencyWaitable = this->swapChain->GetFrameLatencyWaitableObject();
+			QueryPerformanceFrequency(&qpcFrequency);
+		}
+
+		DXGIFramePacingBackend(const DXGIFramePacingBackend&) = delete;
+		DXGIFramePacingBackend& operator=(const DXGIFramePacingBackend&) = delete;
+
+		~DXGIFramePacingBackend()
+		{
+			if(frameLatencyWaitable)
+				CloseHandle(frameLatencyWaitable);
+		}
+
+	public:
+		void SetMaximumFrameLatency(UINT maximumFrameLatency) { swapChain->SetMaximumFrameLatency(maximumFrameLatency); }
+
+		/// <summary>
+		/// Alertable wait on the frame latency waitable object. Returns WAIT_OBJECT_0, WAIT_TIMEOUT or WAIT_IO_COMPLETION
+		/// </summary>
+		DWORD WaitForFrameLatency(DWORD milliseconds)
+		{
+			if(!frameLatencyWaitable)
+				return WAIT_OBJECT_0;
+
+			const DWORD result = WaitForSingleObjectEx(frameLatencyWaitable, milliseconds, TRUE);
+			if(result == WAIT_FAILED)
+				ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+			return result;
+		}
+
+		void Signal(UINT64 value) { ThrowIfFailed(queue->Signal(fence, value)); }
+		void WaitForFence(UINT64 value) { fenceWaiter.Wait(*fence.Get(), value); }
+		void Present(UINT syncInterval, UINT presentFlags) { swapChain->Present(syncInterval, presentFlags); }
+		UINT GetLastPresentCount() { return swapChain->GetLastPresentCount(); }
+		UINT GetCurrentBackBufferIndex() { return swapChain->GetCurrentBackBufferIndex(); }
+
+		//Frame statistics are unavailable for windowed flip model swap chains which aren't independently flipped
+		bool GetFrameStatistics(DXGI_FRAME_STATISTICS& frameStatistics) { return SUCCEEDED(swapChain.Get()->GetFrameStatistics(&frameStatistics)); }
+
+		LARGE_INTEGER GetTime()
+		{
+			LARGE_INTEGER time;
+			QueryPerformanceCounter(&time);
+			return time;
+		}
+
+		LARGE_INTEGER GetTimeFrequency() const noexcept { return qpcFrequency; }
+		const Helpers::D3D12::AdaptiveFenceWaiter::Statistics& GetFenceWaitStatistics() const noexcept { return fenceWaiter.GetStatistics(); }
+	};
+
+	/// <summary>
+	/// Keeps at most framesInFlight frames of CPU work ahead of the GPU, each owning a Slot of per-frame resources,
+	/// and at most maximumFrameLatency presents queued by waiting on the swap chain's frame latency waitable object at the start of every frame.
+	/// Waiting there, before input is sampled, keeps the input to photon latency down and prevents queued frames from piling up.
+	/// The backend provides SetMaximumFrameLatency, WaitForFrameLatency, Signal, WaitForFence, Present, GetLastPresentCount,
+	/// GetCurrentBackBufferIndex, GetFrameStatistics, GetTime and GetTimeFrequency
+	/// </summary>
+	export template<class Slot, class Backend>
+	class BasicFramePacer
+	{
+	public:
+		struct Frame
+		{
+			UINT slotIndex;
+			UINT backBufferIndex;
+			Slot& slot;
+		};
+
+	private:
+		struct PresentRecord
+		{
+			UINT presentCount = 0;
+			LARGE_INTEGER frameStart{};
+		};
+
+		Backend backend;
+
+		std::vector<Slot> slots;
+		std::vector<UINT64> slotFenceValues;
+		UINT64 fenceValue = 0;
+		UINT currentSlot = 0;
+		bool inFrame = false;
+
+		LARGE_INTEGER frameStart{};
+		std::vector<PresentRecord> presents;
+		UINT lastMatchedPresentCount = 0;
+		FramePacingStatistics statistics;
+
+	public:
+		template<class... BackendArgs>
+		BasicFramePacer(UINT framesInFlight, UINT maximumFrameLatency, BackendArgs&&... backendArgs) :
+			backend{ std::forward<BackendArgs>(backendArgs)... },
+			slots(framesInFlight),
+			slotFenceValues(framesInFlight, 0),
+			presents(framesInFlight + maximumFrameLatency + 1)
+		{
+			if(framesInFlight == 0 || maximumFrameLatency == 0)
+				throw std::invalid_argument("A frame pacer needs at least one frame in flight and a frame latency of at least one");
+
+			backend.SetMaximumFrameLatency(maximumFrameLatency);
+		}
+
+		BasicFramePacer(const BasicFramePacer&) = delete;
+		BasicFramePacer& operator=(const BasicFramePacer&) = delete;
+
+		~BasicFramePacer()
+		{
+			//The wait only fails once the device is lost, and then the GPU no longer uses the slots
+			try
+			{
+				WaitForIdle();
+			}
+			catch(...)
+			{
+			}
+		}
+
+	public:
+		/// <summary>
+		/// Blocks until the swap chain can accept another frame and the GPU is done with the slot being reused.
+		/// Sample input after this returns
+		/// </summary>
+		Frame BeginFrame()
+		{
+			assert(!inFrame);
+
+			//The wait is alertable, APCs running on this thread end it early without the swap chain being ready
+			DWORD waitResult;
+			do
+			{
+				waitResult = backend.WaitForFrameLatency(1000);
+			} while(waitResult == WAIT_IO_COMPLETION);
+
+			if(waitResult == WAIT_TIMEOUT)
+				statistics.frameLatencyTimeouts++;
+
+			backend.WaitForFence(slotFenceValues[currentSlot]);
+
+			frameStart = backend.GetTime();
+			inFrame = true;
+			return { currentSlot, backend.GetCurrentBackBufferIndex(), slots[currentSlot] };
+		}
+
+		/// <summary>
+		/// Call after the frame's command lists have been executed on the queue
+		/// </summary>
+		void EndFrame(UINT syncInterval, UINT presentFlags = 0)
+		{
+			assert(inFrame);
+			inFrame = false;
+
+			slotFenceValues[currentSlot] = ++fenceValue;
+			backend.Signal(fenceValue);
+
+			backend.Present(syncInterval, presentFlags);
+			statistics.framesPresented++;
+
+			const UINT presentCount = backend.GetLastPresentCount();
+			presents[presentCount % presents.size()] = { presentCount, frameStart };
+			UpdateStatistics(presentCount);
+
+			currentSlot = (currentSlot + 1) % static_cast<UINT>(slots.size());
+		}
+
+		void WaitForIdle()
+		{
+			backend.WaitForFence(fenceValue);
+		}
+
+	public:
+		UINT GetFramesInFlight() const noexcept { return static_cast<UINT>(slots.size()); }
+		Slot& GetSlot(UINT index) { return slots[index]; }
+		const FramePacingStatistics& GetStatistics() const noexcept { return statistics; }
+		Backend& GetBackend() noexcept { return backend; }
+		const Backend& GetBackend() const noexcept { return backend; }
+
+	private:
+		void UpdateStatistics(UINT lastPresentCount)
+		{
+			DXGI_FRAME_STATISTICS frameStatistics{};
+			if(!backend.GetFrameStatistics(frameStatistics) || frameStatistics.PresentCount == 0)
+				return;
+
+			statistics.queuedPresents = lastPresentCount - frameStatistics.PresentCount;
+			if(frameStatistics.PresentCount == lastMatchedPresentCount)
+				return;
+
+			const PresentRecord& record = presents[frameStatistics.PresentCount % presents.size()];
+			if(record.presentCount != frameStatistics.PresentCount)
+				return;
+
+			lastMatchedPresentCount = frameStatistics.PresentCount;
+			statistics.lastLatencyMilliseconds = static_cast<double>(frameStatistics.SyncQPCTime.QuadPart - record.frameStart.QuadPart) * 1000.0 / static_cast<double>(backend.GetTimeFrequency().QuadPart);
+			statistics.averageLatencyMilliseconds = statistics.averageLatencyMilliseconds == 0
+				? statistics.lastLatencyMilliseconds
+				: statistics.averageLatencyMilliseconds + (statistics.lastLatencyMilliseconds - statistics.averageLatencyMilliseconds) / 16.0;
+		}
+	};
+
+	/// <summary>
+	/// Paces a D3D12 queue presenting to a DXGI swap chain.
+	/// The swap chain must be created with DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT
+	/// </summary>
+	export template<class Slot>
+	class FramePacer : public BasicFramePacer<Slot, DXGIFramePacingBackend>
+	{
+		using Base = BasicFramePacer<Slot, DXGIFramePacingBackend>;
+
+	public:
+		FramePacer(
+			Wrapper<IDXGISwapChain3> swapChain,
+			Direct<ID3D12CommandQueue> queue,
+			gsl::not_null<WrapperView<ID3D12Device>> device,
+			UINT framesInFlight = 2,
+			UINT maximumFrameLatency = 1) :
+			Base{ framesInFlight, maximumFrameLatency, std::move(swapChain), std::move(queue), device }
+		{
+		}
+
+	public:
+		const Helpers::D3D12::AdaptiveFenceWaiter::Statistics& GetFenceWaitStatistics() const noexcept { return this->GetBackend().GetFenceWaitStatistics(); }
+	};
+}
@@ -90,7 +90,7 @@ namespace TypedD3D
 
 			DXGI_FRAME_STATISTICS GetFrameStatistics()
 			{
-				DXGI_FRAME_STATISTICS stats;
+				DXGI_FRAME_STATISTICS stats{};
 				Self().GetFrameStatistics(&stats);
 				return stats;
 			}
@@ -233,7 +233,7 @@ namespace TypedD3D
 
 			void SetMaximumFrameLatency(UINT MaxLatency)
 			{
-				ThrowIfFailed(Self().SetMaximumFrameLatency(&MaxLatency));
+				ThrowIfFailed(Self().SetMaximumFrameLatency(MaxLatency));
 			}
 
 			UINT STDMETHODCALLTYPE GetMaximumFrameLatency()
@@ -0,0 +1,88 @@
+module;
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+export module TypedD3D.Shared:Hash;
+
+namespace TypedD3D
+{
+	constexpr std::uint64_t fnvOffsetBasis = 14695981039346656037ull;
+	constexpr std::uint64_t fnvPrime = 1099511628211ull;
+
+	export constexpr std::uint64_t HashBytes(std::span<const std::byte> bytes, std::uint64_t seed = fnvOffsetBasis) noexcept
+	{
+		std::uint64_t hash = seed;
+		for(std::byte b : bytes)
+		{
+			hash ^= static_cast<std::uint64_t>(b);
+			hash *= fnvPrime;
+		}
+		return hash;
+	}
+
+	export constexpr std::uint64_t HashCombine(std::uint64_t seed, std::uint64_t value) noexcept
+	{
+		return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+	}
+
+	/// <summary>
+	/// An owning, canonical byte representation of a description used as a cache key.
+	/// Structs containing pointers or padding must be appended field by field so that two equal descriptions produce the same key
+	/// </summary>
+	export class HashKey
+	{
+		std::vector<std::byte> bytes;
+		std::uint64_t hash = fnvOffsetBasis;
+
+	public:
+		HashKey() = default;
+
+		template<class Ty>
+			requires std::is_trivially_copyable_v<Ty> && (!std::is_pointer_v<Ty>)
+		HashKey& Append(const Ty& value)
+		{
+			return AppendBytes(std::as_bytes(std::span{ &value, 1 }));
+		}
+
+		template<class Ty>
+			requires std::is_trivially_copyable_v<Ty> && (!std::is_pointer_v<Ty>)
+		HashKey& Append(std::span<const Ty> values)
+		{
+			Append(values.size());
+			return AppendBytes(std::as_bytes(values));
+		}
+
+		HashKey& AppendBytes(std::span<const std::byte> data)
+		{
+			bytes.insert(bytes.end(), data.begin(), data.end());
+			hash = HashBytes(data, hash);
+			return *this;
+		}
+
+		HashKey& AppendString(std::string_view string)
+		{
+			Append(string.size());
+			return AppendBytes(std::as_bytes(std::span{ string.data(), string.size() }));
+		}
+
+	public:
+		std::uint64_t GetHash() const noexcept { return hash; }
+		std::span<const std::byte> GetBytes() const noexcept { return bytes; }
+
+		bool operator==(const HashKey& other) const noexcept
+		{
+			return hash == other.hash && bytes == other.bytes;
+		}
+	};
+
+	export struct HashKeyHasher
+	{
+		std::size_t operator()(const HashKey& key) const noexcept { return static_cast<std::size_t>(key.GetHash()); }
+	};
+}
@@ -0,0 +1,229 @@
+module;
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <source_location>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+export module TypedD3D.Shared:Instrumentation;
+
+namespace TypedD3D::Instrumentation
+{
+	/// <summary>
+	/// Defining TYPEDD3D_INSTRUMENTATION when building the modules times every wrapped interface call.
+	/// When it isn't defined InterfaceBase::Self takes no arguments and AddArgumentCount is an empty constexpr function,
+	/// so the wrappers compile to the same code as without instrumentation. CompileTest checks both at compile time
+	/// </summary>
+#ifdef TYPEDD3D_INSTRUMENTATION
+	export constexpr bool enabled = true;
+#else
+	export constexpr bool enabled = false;
+#endif
+
+	export struct CallStatistics
+	{
+		//The wrapper function's name, as given by std::source_location
+		const char* function = nullptr;
+		std::uint64_t calls = 0;
+		std::chrono::nanoseconds time{};
+
+		//Sum of the element counts the wrapper reported through AddArgumentCount, such as barriers, descriptors or command lists
+		std::uint64_t argumentCount = 0;
+	};
+
+	//function_name returns a string with static storage, but the same function may get a copy per translation unit, so the contents are the key
+	using CallMap = std::unordered_map<std::string_view, CallStatistics>;
+
+	void Merge(CallMap& into, const CallMap& from)
+	{
+		for(const auto& [function, call] : from)
+		{
+			CallStatistics& statistics = into.try_emplace(function, CallStatistics{ .function = call.function }).first->second;
+			statistics.calls += call.calls;
+			statistics.time += call.time;
+			statistics.argumentCount += call.argumentCount;
+		}
+	}
+
+	struct ThreadRecorder;
+
+	//Every live thread's recorder, and the calls of the threads which have exited since the last reset
+	struct RecorderRegistry
+	{
+		std::mutex mutex;
+		std::vector<ThreadRecorder*> recorders;
+		CallMap exitedCalls;
+	};
+
+	RecorderRegistry& GetRecorderRegistry()
+	{
+		static RecorderRegistry registry;
+		return registry;
+	}
+
+	/// <summary>
+	/// Only locked by its own thread while recording, so the lock is uncontended unless statistics are being gathered.
+	/// Lock the registry before a recorder
+	/// </summary>
+	struct ThreadRecorder
+	{
+		std::mutex mutex;
+		CallMap calls;
+
+		ThreadRecorder()
+		{
+			RecorderRegistry& registry = GetRecorderRegistry();
+			std::scoped_lock lock{ registry.mutex };
+			registry.recorders.push_back(this);
+		}
+
+		ThreadRecorder(const ThreadRecorder&) = delete;
+		ThreadRecorder& operator=(const ThreadRecorder&) = delete;
+
+		~ThreadRecorder()
+		{
+			RecorderRegistry& registry = GetRecorderRegistry();
+			std::scoped_lock lock{ registry.mutex, mutex };
+			std::erase(registry.recorders, this);
+
+			//Losing the exiting thread's calls is better than terminating if merging them runs out of memory
+			try
+			{
+				Merge(registry.exitedCalls, calls);
+			}
+			catch(...)
+			{
+			}
+		}
+	};
+
+	//Kept apart from the recorder so that reporting arguments never allocates
+	thread_local std::uint64_t pendingArguments = 0;
+
+	ThreadRecorder& GetThreadRecorder()
+	{
+		thread_local ThreadRecorder recorder;
+		return recorder;
+	}
+
+	std::vector<CallStatistics> SortByTime(const CallMap& calls)
+	{
+		std::vector<CallStatistics> statistics;
+		for(const auto& [function, call] : calls)
+			statistics.push_back(call);
+
+		std::ranges::sort(statistics, std::ranges::greater{}, &CallStatistics::time);
+		return statistics;
+	}
+
+	/// <summary>
+	/// Lives for the full expression of a wrapped call as a default argument of InterfaceBase::Self
+	/// </summary>
+	export class CallScope
+	{
+		const char* function;
+		std::chrono::steady_clock::time_point start;
+
+	public:
+		CallScope(std::source_location location) noexcept :
+			function{ location.function_name() },
+			start{ std::chrono::steady_clock::now() }
+		{
+		}
+
+		CallScope(const CallScope&) = delete;
+		CallScope& operator=(const CallScope&) = delete;
+
+		~CallScope()
+		{
+			const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+
+			//Inserting a function seen for the first time allocates, if that fails the call is dropped from the statistics rather than terminating
+			try
+			{
+				const std::uint64_t arguments = std::exchange(pendingArguments, 0);
+				ThreadRecorder& recorder = GetThreadRecorder();
+				std::scoped_lock lock{ recorder.mutex };
+				CallStatistics& statistics = recorder.calls.try_emplace(function, CallStatistics{ .function = function }).first->second;
+				statistics.calls++;
+				statistics.time += elapsed;
+				statistics.argumentCount += arguments;
+			}
+			catch(...)
+			{
+			}
+		}
+	};
+
+	/// <summary>
+	/// Attributes a number of elements to the next wrapped call made by the thread. Does nothing when instrumentation is disabled
+	/// </summary>
+#ifdef TYPEDD3D_INSTRUMENTATION
+	export inline void AddArgumentCount(std::size_t count) noexcept
+	{
+		pendingArguments += count;
+	}
+#else
+	export constexpr void AddArgumentCount(std::size_t) noexcept
+	{
+	}
+#endif
+
+	/// <summary>
+	/// The calls made by the calling thread since the last reset, most expensive first
+	/// </summary>
+	export std::vector<CallStatistics> GetThreadCallStatistics()
+	{
+		ThreadRecorder& recorder = GetThreadRecorder();
+		std::scoped_lock lock{ recorder.mutex };
+		return SortByTime(recorder.calls);
+	}
+
+	export void ResetThreadCallStatistics()
+	{
+		ThreadRecorder& recorder = GetThreadRecorder();
+		std::scoped_lock lock{ recorder.mutex };
+		recorder.calls.clear();
+		pendingArguments = 0;
+	}
+
+	/// <summary>
+	/// The calls made by every thread since the last reset, including threads which have exited, most expensive first
+	/// </summary>
+	export std::vector<CallStatistics> GetCallStatistics()
+	{
+		RecorderRegistry& registry = GetRecorderRegistry();
+		std::scoped_lock lock{ registry.mutex };
+
+		CallMap calls = registry.exitedCalls;
+		for(ThreadRecorder* recorder : registry.recorders)
+		{
+			std::scoped_lock recorderLock{ recorder->mutex };
+			Merge(calls, recorder->calls);
+		}
+		return SortByTime(calls);
+	}
+
+	/// <summary>
+	/// Clears the statistics of every thread. Only the calling thread's pending AddArgumentCount is dropped
+	/// </summary>
+	export void ResetCallStatistics()
+	{
+		RecorderRegistry& registry = GetRecorderRegistry();
+		std::scoped_lock lock{ registry.mutex };
+
+		registry.exitedCalls.clear();
+		for(ThreadRecorder* recorder : registry.recorders)
+		{
+			std::scoped_lock recorderLock{ recorder->mutex };
+			recorder->calls.clear();
+		}
+		pendingArguments = 0;
+	}
+}
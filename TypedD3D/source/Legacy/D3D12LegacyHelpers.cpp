@@ -14,6 +14,7 @@ module;
 #include <assert.h>
 #include <algorithm>
 #include <optional>
+#include <stdexcept>
 
 module TypedD3D.Legacy.D3D12Helpers;
 
@@ -37,23 +38,91 @@ namespace TypedD3D::Helpers::D3D12
         StallCPUThread(fence, currentFenceValue, waitEvent);
     }
 
-    void StallCPUThread(ID3D12Fence& fence, UINT64 fenceValue, HANDLE waitEvent, std::chrono::milliseconds waitInterval)
+    AdaptiveFenceWaiter::AdaptiveFenceWaiter(std::chrono::nanoseconds maxSpin) :
+        maxSpin{ maxSpin }
     {
-        if(fence.GetCompletedValue() < fenceValue)
+    }
+
+    AdaptiveFenceWaiter::~AdaptiveFenceWaiter()
+    {
+        if(ownedEvent)
+            CloseHandle(ownedEvent);
+    }
+
+    void AdaptiveFenceWaiter::Wait(ID3D12Fence& fence, UINT64 fenceValue, HANDLE waitEvent, std::chrono::milliseconds waitInterval)
+    {
+        if(fence.GetCompletedValue() >= fenceValue)
         {
-            HRESULT hr = fence.SetEventOnCompletion(fenceValue, waitEvent);
-            if(FAILED(hr) && hr == E_OUTOFMEMORY)
-                throw std::runtime_error("Out of memory");
+            statistics.alreadyCompleted++;
+            RecordLatency(std::chrono::nanoseconds::zero());
+            return;
+        }
 
-            if(waitEvent != nullptr)
-            {
-                while(WaitForSingleObject(waitEvent, static_cast<DWORD>(waitInterval.count())))
-                {
+        using clock = std::chrono::steady_clock;
+        const clock::time_point start = clock::now();
+        const std::chrono::nanoseconds spinWindow = GetSpinWindow();
 
+        while(clock::now() - start < spinWindow)
+        {
+            if(fence.GetCompletedValue() >= fenceValue)
+            {
+                statistics.resolvedSpinning++;
+                RecordLatency(clock::now() - start);
+                return;
+            }
+            YieldProcessor();
+        }
 
-                }
+        if(waitEvent == nullptr)
+        {
+            if(ownedEvent == nullptr)
+            {
+                ownedEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+                if(ownedEvent == nullptr)
+                    throw std::runtime_error("Failed to create the fence wait event");
             }
+            waitEvent = ownedEvent;
+        }
+
+        HRESULT hr = fence.SetEventOnCompletion(fenceValue, waitEvent);
+        if(FAILED(hr))
+            throw std::runtime_error("Failed to set the fence completion event");
+
+        //The event may still be signaled by an earlier wait, so completion is always confirmed through the fence
+        while(fence.GetCompletedValue() < fenceValue)
+        {
+            if(WaitForSingleObject(waitEvent, static_cast<DWORD>(waitInterval.count())) == WAIT_FAILED)
+                throw std::runtime_error("Failed to wait on the fence event");
         }
+
+        statistics.resolvedBlocking++;
+        RecordLatency(clock::now() - start);
+    }
+
+    std::chrono::nanoseconds AdaptiveFenceWaiter::GetSpinWindow() const noexcept
+    {
+        //Recent waits outlasting the spin budget means spinning would only burn the core.
+        //Blocking latencies include the cost of waking the thread, so a short probe is still spun to notice when waits get short again
+        if(statistics.latencyEstimate > maxSpin)
+            return (std::min)(probeSpin, maxSpin);
+
+        return (std::min)(statistics.latencyEstimate * 2 + std::chrono::microseconds(1), maxSpin);
+    }
+
+    void AdaptiveFenceWaiter::RecordLatency(std::chrono::nanoseconds latency) noexcept
+    {
+        statistics.latencyEstimate += (latency - statistics.latencyEstimate) / 8;
+    }
+
+    AdaptiveFenceWaiter& GetThreadFenceWaiter()
+    {
+        thread_local AdaptiveFenceWaiter waiter;
+        return waiter;
+    }
+
+    void StallCPUThread(ID3D12Fence& fence, UINT64 fenceValue, HANDLE waitEvent, std::chrono::milliseconds waitInterval)
+    {
+        GetThreadFenceWaiter().Wait(fence, fenceValue, waitEvent, waitInterval);
     }
 
     void StallCommandQueue(ID3D12CommandQueue& commandQueue, ID3D12Fence& fence, UINT64 fenceValue)
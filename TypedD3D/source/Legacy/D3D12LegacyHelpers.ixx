@@ -166,12 +166,63 @@ export namespace TypedD3D::Helpers::D3D12
     constexpr std::chrono::milliseconds waitForCompletion = (std::chrono::milliseconds::max)();
 
     /// <summary>
-    /// Stalls the calling CPU thread by putting it to sleep until the given fence has been signaled to a given value by another thread or the GPU
+    /// Waits for fences by polling GetCompletedValue for a short window before falling back to an event wait.
+    /// The spin window follows a running estimate of how long recent waits took to complete, short waits resolve without paying for a trip through the scheduler
+    /// while long waits only spin for a short probe, which lets the estimate recover once waits get short again. Not thread safe, give every waiting thread its own waiter
+    /// </summary>
+    class AdaptiveFenceWaiter
+    {
+    public:
+        struct Statistics
+        {
+            UINT64 alreadyCompleted = 0;
+            UINT64 resolvedSpinning = 0;
+            UINT64 resolvedBlocking = 0;
+            std::chrono::nanoseconds latencyEstimate{};
+        };
+
+        static constexpr std::chrono::nanoseconds defaultMaxSpin = std::chrono::microseconds(50);
+        static constexpr std::chrono::nanoseconds probeSpin = std::chrono::microseconds(2);
+
+    private:
+        HANDLE ownedEvent = nullptr;
+        std::chrono::nanoseconds maxSpin;
+        Statistics statistics;
+
+    public:
+        AdaptiveFenceWaiter(std::chrono::nanoseconds maxSpin = defaultMaxSpin);
+        AdaptiveFenceWaiter(const AdaptiveFenceWaiter&) = delete;
+        AdaptiveFenceWaiter& operator=(const AdaptiveFenceWaiter&) = delete;
+        ~AdaptiveFenceWaiter();
+
+    public:
+        /// <summary>
+        /// Returns once the fence has reached the value
+        /// </summary>
+        /// <param name="waitEvent">The event to block on once spinning gave up, the waiter's own event is used if nullptr</param>
+        /// <param name="waitInterval">How long every blocking wait lasts before the fence is checked again</param>
+        void Wait(ID3D12Fence& fence, UINT64 fenceValue, HANDLE waitEvent = nullptr, std::chrono::milliseconds waitInterval = waitForCompletion);
+
+        std::chrono::nanoseconds GetSpinWindow() const noexcept;
+        const Statistics& GetStatistics() const noexcept { return statistics; }
+
+    private:
+        void RecordLatency(std::chrono::nanoseconds latency) noexcept;
+    };
+
+    /// <summary>
+    /// The waiter StallCPUThread uses on the calling thread
+    /// </summary>
+    AdaptiveFenceWaiter& GetThreadFenceWaiter();
+
+    /// <summary>
+    /// Stalls the calling CPU thread until the given fence has been signaled to a given value by another thread or the GPU.
+    /// The thread briefly spins on the fence before going to sleep, see AdaptiveFenceWaiter
     /// </summary>
     /// <param name="fence">Fence that the GPU will signal </param>
     /// <param name="fenceValue">The value we're waiting to be signaled</param>
-    /// <param name="waitEvent">The syncing primitive given by windows, passing a nullptr will cause the fence to wait until the fence has been signaled to given value</param>
-    /// <param name="waitInterval">How long the thread will stall for to check for completion. If the default value (equivalent to std::chrono::milliseconds::max()) is passed, the thread will be asleep until the fence has been signaled to the given value. If waitEvent is nullptr, this param is unused</param>
+    /// <param name="waitEvent">The syncing primitive given by windows, passing a nullptr uses an event owned by the calling thread</param>
+    /// <param name="waitInterval">How long the thread will sleep for before checking for completion again. If the default value (equivalent to std::chrono::milliseconds::max()) is passed, the thread will be asleep until the fence has been signaled to the given value</param>
     void StallCPUThread(ID3D12Fence& fence, UINT64 fenceValue, HANDLE waitEvent = nullptr, std::chrono::milliseconds waitInterval = waitForCompletion);
 
     /// <summary>
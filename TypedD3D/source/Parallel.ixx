@@ -0,0 +1,33 @@
+module;
+
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+export module TypedD3D.Shared:Parallel;
+
+namespace TypedD3D
+{
+	/// <summary>
+	/// Calls task(i) for every i in [0, taskCount) and returns once they all returned, tasks may run concurrently.
+	/// Lets the helpers that split their work across threads run it on the application's job system
+	/// </summary>
+	export using ParallelFor = std::function<void(std::size_t taskCount, const std::function<void(std::size_t)>& task)>;
+
+	/// <summary>
+	/// The default ParallelFor, runs task 0 on the calling thread and every other task on a thread of its own
+	/// </summary>
+	export void RunOnThreads(std::size_t taskCount, const std::function<void(std::size_t)>& task)
+	{
+		if(taskCount == 0)
+			return;
+
+		std::vector<std::jthread> threads;
+		threads.reserve(taskCount - 1);
+		for(std::size_t i = 1; i < taskCount; i++)
+			threads.emplace_back(task, i);
+
+		task(0);
+	}
+}
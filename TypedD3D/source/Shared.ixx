@@ -8,7 +8,11 @@ module;
 #include <d3dcommon.h>
 
 export module TypedD3D.Shared;
+export import :Alignment;
 export import :Containers;
+export import :Hash;
+export import :Instrumentation;
+export import :Parallel;
 
 namespace TypedD3D
 {
@@ -8,5 +8,10 @@ export import :Resources;
 export import :ResourceViews;
 export import :States;
 export import :Shaders;
+export import :ParallelRecorder;
+export import :RenderThreadQueue;
+export import :DynamicBufferRing;
+export import :ConstantBufferPacker;
+export import :StateObjectCache;
 
 export namespace TypedD3D11 = TypedD3D::D3D11;
@@ -9,6 +9,22 @@ export import :Resource;
 export import :Device;
 export import :Wrappers;
 export import :D3D12Object;
+export import :RootSignatureCache;
+export import :RootSignatureLayout;
+export import :UploadRingAllocator;
+export import :ConstantBufferAllocator;
+export import :TextureUploader;
+export import :TLSFAllocator;
+export import :ResourceAllocationInfoCache;
+export import :PlacedResourceAllocator;
+export import :TransientResourcePlanner;
+export import :ResidencyManager;
+export import :FenceAwaiter;
+export import :SubmissionGraph;
+export import :GpuProfiler;
+export import :CommandStream;
+export import :DrawQueue;
+export import :IndirectBatcher;
 
 export namespace TypedD3D12 = TypedD3D::D3D12;
 
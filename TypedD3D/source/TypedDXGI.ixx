@@ -4,5 +4,6 @@ export import :DXGIObject;
 export import :Adapter;
 export import :Factory;
 export import :SwapChain;
+export import :FramePacer;
 
 export namespace TypedDXGI = TypedD3D::DXGI;
@@ -0,0 +1,336 @@
+//*********************************************************
+//
+// Copyright (c) 2022 Renzy Alarcon
+// Licensed under the MIT License (MIT).
+//
+//*********************************************************
+
+#pragma once
+#include "span_tuple.h"
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#if !defined(XK_SPAN_TUPLE_NO_SIMD)
+#if defined(__AVX2__)
+#define XK_SPAN_TUPLE_AVX2
+#endif
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XK_SPAN_TUPLE_SSE2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(XK_SPAN_TUPLE_AVX2)
+#define XK_SPAN_TUPLE_SIMD_NAMESPACE avx2
+#elif defined(XK_SPAN_TUPLE_SSE2)
+#define XK_SPAN_TUPLE_SIMD_NAMESPACE sse2
+#else
+#define XK_SPAN_TUPLE_SIMD_NAMESPACE scalar
+#endif
+
+namespace xk
+{
+//Translation units built for different instruction sets get distinct functions instead of breaking the one definition rule
+inline namespace XK_SPAN_TUPLE_SIMD_NAMESPACE
+{
+    //How far ahead of the current element prefetches are issued
+    inline constexpr size_t prefetch_distance_bytes = 512;
+
+    //Spans smaller than this are assumed to already be in cache and are walked without prefetching
+    inline constexpr size_t prefetch_threshold_bytes = 64 * 1024;
+
+    //Hints that address is about to be read. Never faults
+    inline void prefetch(const void* address) noexcept
+    {
+#if defined(XK_SPAN_TUPLE_SSE2)
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#elif defined(__GNUC__)
+        __builtin_prefetch(address);
+#else
+        (void)address;
+#endif
+    }
+
+    namespace details
+    {
+        template<class Ty>
+        constexpr size_t prefetch_distance = std::max<size_t>(1, prefetch_distance_bytes / sizeof(Ty));
+
+        //Types that can be moved around by SIMD gathers as plain 4 or 8 byte lanes
+        template<class Ty>
+        concept simd_lane = std::is_trivially_copyable_v<Ty> && (sizeof(Ty) == 4 || sizeof(Ty) == 8);
+
+        template<class Ty, class Op>
+        concept simd_sum = (std::same_as<Op, std::plus<>> || std::same_as<Op, std::plus<Ty>>) &&
+            (std::same_as<Ty, float> || std::same_as<Ty, std::int32_t> || std::same_as<Ty, std::uint32_t>);
+
+        template<size_t Extent, class First, class... Ty>
+        bool needs_prefetch(const span_tuple<Extent, First, Ty...>& span) noexcept
+        {
+            return span.size() * (sizeof(First) + ... + sizeof(Ty)) >= prefetch_threshold_bytes;
+        }
+
+        template<class Ty>
+        Ty sum(const Ty* data, size_t count, Ty init) noexcept
+        {
+            size_t i = 0;
+#if defined(XK_SPAN_TUPLE_AVX2)
+            if constexpr(std::same_as<Ty, float>)
+            {
+                __m256 first = _mm256_setzero_ps();
+                __m256 second = _mm256_setzero_ps();
+                for(; i + 16 <= count; i += 16)
+                {
+                    first = _mm256_add_ps(first, _mm256_loadu_ps(data + i));
+                    second = _mm256_add_ps(second, _mm256_loadu_ps(data + i + 8));
+                }
+                alignas(32) float lanes[8];
+                _mm256_store_ps(lanes, _mm256_add_ps(first, second));
+                for(float lane : lanes)
+                    init += lane;
+            }
+            else
+            {
+                __m256i total = _mm256_setzero_si256();
+                for(; i + 8 <= count; i += 8)
+                    total = _mm256_add_epi32(total, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+                alignas(32) Ty lanes[8];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), total);
+                for(Ty lane : lanes)
+                    init += lane;
+            }
+#elif defined(XK_SPAN_TUPLE_SSE2)
+            if constexpr(std::same_as<Ty, float>)
+            {
+                __m128 first = _mm_setzero_ps();
+                __m128 second = _mm_setzero_ps();
+                for(; i + 8 <= count; i += 8)
+                {
+                    first = _mm_add_ps(first, _mm_loadu_ps(data + i));
+                    second = _mm_add_ps(second, _mm_loadu_ps(data + i + 4));
+                }
+                alignas(16) float lanes[4];
+                _mm_store_ps(lanes, _mm_add_ps(first, second));
+                for(float lane : lanes)
+                    init += lane;
+            }
+            else
+            {
+                __m128i total = _mm_setzero_si128();
+                for(; i + 4 <= count; i += 4)
+                    total = _mm_add_epi32(total, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+                alignas(16) Ty lanes[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes), total);
+                for(Ty lane : lanes)
+                    init += lane;
+            }
+#endif
+            for(; i < count; i++)
+                init += data[i];
+            return init;
+        }
+    }
+
+    /// <summary>
+    /// Calls fn(first, others...) for every element. Walks the columns by index rather than through span_tuple_iterator,
+    /// and prefetches every column ahead of the walk when the span is large
+    /// </summary>
+    template<size_t Extent, class First, class... Ty, class Fn>
+    void for_each(span_tuple<Extent, First, Ty...> span, Fn&& fn)
+    {
+        auto walk = [&](auto... columns)
+        {
+            const size_t count = span.size();
+            size_t i = 0;
+            if(details::needs_prefetch(span))
+            {
+                constexpr size_t distance = std::max({ details::prefetch_distance<First>, details::prefetch_distance<Ty>... });
+                for(; i + distance < count; i++)
+                {
+                    (prefetch(columns + i + distance), ...);
+                    fn(columns[i]...);
+                }
+            }
+            for(; i < count; i++)
+                fn(columns[i]...);
+        };
+        std::apply(walk, span.data());
+    }
+
+    //Assigns a value to every element of every column
+    template<size_t Extent, class First, class... Ty>
+    void fill(span_tuple<Extent, First, Ty...> span, const std::remove_cv_t<First>& first, const std::remove_cv_t<Ty>&... others)
+    {
+        std::apply([&](First* firstColumn, Ty*... otherColumns)
+        {
+            std::fill_n(firstColumn, span.size(), first);
+            (std::fill_n(otherColumns, span.size(), others), ...);
+        }, span.data());
+    }
+
+    //Writes fn(input[i]) to output[i]
+    template<class InTy, size_t InExtent, class OutTy, size_t OutExtent, class Fn>
+    void transform(std::span<InTy, InExtent> input, std::span<OutTy, OutExtent> output, Fn&& fn)
+    {
+        assert(input.size() == output.size() && "transform requires the output to be as large as the input");
+        InTy* in = input.data();
+        OutTy* out = output.data();
+        for(size_t i = 0; i < input.size(); i++)
+            out[i] = fn(in[i]);
+    }
+
+    //Writes fn(first[i], others[i]...) to output[i], building one column out of several
+    template<size_t Extent, class First, class... Ty, class OutTy, size_t OutExtent, class Fn>
+    void transform(span_tuple<Extent, First, Ty...> input, std::span<OutTy, OutExtent> output, Fn&& fn)
+    {
+        assert(input.size() == output.size() && "transform requires the output to be as large as the input");
+        OutTy* out = output.data();
+        size_t i = 0;
+        for_each(input, [&](auto&... elements) { out[i++] = fn(elements...); });
+    }
+
+    /// <summary>
+    /// destination[i] = source[indices[i]].
+    /// 4 and 8 byte types are gathered 8 and 4 at a time with AVX2, everything else is copied one at a time with the sources prefetched
+    /// </summary>
+    template<class Ty, size_t Extent, size_t IndexExtent, size_t OutExtent>
+    void gather(std::span<const Ty, Extent> source, std::span<const std::uint32_t, IndexExtent> indices, std::span<Ty, OutExtent> destination)
+    {
+        assert(indices.size() == destination.size() && "gather requires an index for every destination element");
+        const Ty* from = source.data();
+        const std::uint32_t* index = indices.data();
+        Ty* to = destination.data();
+        const size_t count = indices.size();
+        size_t i = 0;
+
+#if defined(XK_SPAN_TUPLE_AVX2)
+        //Gather instructions take signed 32 bit indices
+        if constexpr(details::simd_lane<Ty>)
+        {
+            if(source.size() <= size_t(std::numeric_limits<std::int32_t>::max()))
+            {
+                if constexpr(sizeof(Ty) == 4)
+                {
+                    for(; i + 8 <= count; i += 8)
+                    {
+                        assert(std::all_of(index + i, index + i + 8, [&](std::uint32_t offset) { return offset < source.size(); }) && "gather index out of range");
+                        const __m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index + i));
+                        const __m256i values = _mm256_i32gather_epi32(reinterpret_cast<const int*>(from), offsets, 4);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i), values);
+                    }
+                }
+                else
+                {
+                    for(; i + 4 <= count; i += 4)
+                    {
+                        assert(std::all_of(index + i, index + i + 4, [&](std::uint32_t offset) { return offset < source.size(); }) && "gather index out of range");
+                        const __m128i offsets = _mm_loadu_si128(reinterpret_cast<const __m128i*>(index + i));
+                        const __m256i values = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(from), offsets, 8);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(to + i), values);
+                    }
+                }
+            }
+        }
+#endif
+
+        constexpr size_t distance = details::prefetch_distance<Ty>;
+        for(; i + distance < count; i++)
+        {
+            assert(index[i] < source.size() && "gather index out of range");
+            prefetch(from + index[i + distance]);
+            to[i] = from[index[i]];
+        }
+        for(; i < count; i++)
+        {
+            assert(index[i] < source.size() && "gather index out of range");
+            to[i] = from[index[i]];
+        }
+    }
+
+    template<class Ty, size_t Extent, size_t IndexExtent, size_t OutExtent>
+        requires (!std::is_const_v<Ty>)
+    void gather(std::span<Ty, Extent> source, std::span<const std::uint32_t, IndexExtent> indices, std::span<Ty, OutExtent> destination)
+    {
+        gather(std::span<const Ty, Extent>(source), indices, destination);
+    }
+
+    /// <summary>
+    /// destination[indices[i]] = source[i].
+    /// There is no scatter instruction below AVX-512, so this is scalar with the destinations prefetched
+    /// </summary>
+    template<class Ty, size_t Extent, size_t IndexExtent, size_t OutExtent>
+    void scatter(std::span<const Ty, Extent> source, std::span<const std::uint32_t, IndexExtent> indices, std::span<Ty, OutExtent> destination)
+    {
+        assert(indices.size() == source.size() && "scatter requires an index for every source element");
+        const Ty* from = source.data();
+        const std::uint32_t* index = indices.data();
+        Ty* to = destination.data();
+        const size_t count = indices.size();
+        constexpr size_t distance = details::prefetch_distance<Ty>;
+
+        size_t i = 0;
+        for(; i + distance < count; i++)
+        {
+            assert(index[i] < destination.size() && "scatter index out of range");
+            prefetch(to + index[i + distance]);
+            to[index[i]] = from[i];
+        }
+        for(; i < count; i++)
+        {
+            assert(index[i] < destination.size() && "scatter index out of range");
+            to[index[i]] = from[i];
+        }
+    }
+
+    template<class Ty, size_t Extent, size_t IndexExtent, size_t OutExtent>
+        requires (!std::is_const_v<Ty>)
+    void scatter(std::span<Ty, Extent> source, std::span<const std::uint32_t, IndexExtent> indices, std::span<Ty, OutExtent> destination)
+    {
+        scatter(std::span<const Ty, Extent>(source), indices, destination);
+    }
+
+    /// <summary>
+    /// Applies one permutation to every column: destination[i] = source[order[i]] for each column.
+    /// Rows stay together, so sorting one column's indices and permuting reorders the whole table.
+    /// source and destination must not overlap
+    /// </summary>
+    template<size_t Extent, class First, class... Ty, size_t OutExtent, class OutFirst, class... OutTy>
+        requires (sizeof...(Ty) == sizeof...(OutTy))
+    void permute(span_tuple<Extent, First, Ty...> source, std::span<const std::uint32_t> order, span_tuple<OutExtent, OutFirst, OutTy...> destination)
+    {
+        assert(order.size() == destination.size() && "permute requires an index for every destination element");
+        [&]<size_t... Indices>(std::index_sequence<Indices...>)
+        {
+            using value_type = std::tuple<std::remove_cv_t<First>, std::remove_cv_t<Ty>...>;
+            (gather(std::span<const std::tuple_element_t<Indices, value_type>>(std::get<Indices>(source.data()), source.size()),
+                order,
+                std::span(std::get<Indices>(destination.data()), destination.size())), ...);
+        }(std::index_sequence_for<First, Ty...>{});
+    }
+
+    /// <summary>
+    /// Folds a column with op. Sums of float, int32 and uint32 columns are vectorized,
+    /// which reassociates float additions so the result can differ from a sequential sum in the last bits
+    /// </summary>
+    template<class Ty, size_t Extent, class ValueTy, class Op = std::plus<>>
+    ValueTy reduce(std::span<Ty, Extent> column, ValueTy init, Op op = {})
+    {
+        using element_type = std::remove_cv_t<Ty>;
+        if constexpr(std::same_as<element_type, ValueTy> && details::simd_sum<element_type, Op>)
+        {
+            return details::sum<element_type>(column.data(), column.size(), init);
+        }
+        else
+        {
+            for(const Ty& element : column)
+                init = op(std::move(init), element);
+            return init;
+        }
+    }
+}
+}